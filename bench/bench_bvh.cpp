@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "ogldev_bvh.h"
+#include "ogldev_frustum.h"
+#include "ogldev_random.h"
+
+// Builds a BVH over a scattered set of boxes and compares its queries
+// against testing every box.
+
+static const size_t kCount = 200000;
+static const float kWorldSize = 1000.0f;
+
+// The brute-force tests, written out the same way as the BVH's own so
+// that both find exactly the same boxes.
+static bool BoxOverlapsSphere(const AABB& b, const Vector3f& c,
+                              float radius) {
+  const float dx = std::max(std::max(b.min.x - c.x, 0.0f), c.x - b.max.x);
+  const float dy = std::max(std::max(b.min.y - c.y, 0.0f), c.y - b.max.y);
+  const float dz = std::max(std::max(b.min.z - c.z, 0.0f), c.z - b.max.z);
+  return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+static bool RayHitsBox(const AABB& b, const Vector3f& origin,
+                       const Vector3f& inv_dir, float t_max) {
+  const float tx0 = (b.min.x - origin.x) * inv_dir.x;
+  const float tx1 = (b.max.x - origin.x) * inv_dir.x;
+  const float ty0 = (b.min.y - origin.y) * inv_dir.y;
+  const float ty1 = (b.max.y - origin.y) * inv_dir.y;
+  const float tz0 = (b.min.z - origin.z) * inv_dir.z;
+  const float tz1 = (b.max.z - origin.z) * inv_dir.z;
+  const float t_enter = std::max(
+      std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+      std::max(std::min(tz0, tz1), 0.0f));
+  const float t_exit = std::min(
+      std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+      std::min(std::max(tz0, tz1), t_max));
+  return t_enter <= t_exit;
+}
+
+int main() {
+  Random rng(1234);
+  std::vector<AABB> boxes(kCount);
+  for (size_t i = 0; i < kCount; i++) {
+    Vector3f c(rng.NextFloat(), rng.NextFloat(), rng.NextFloat());
+    Vector3f e(rng.NextFloat(), rng.NextFloat(), rng.NextFloat());
+    c = (c - Vector3f(0.5f)) * kWorldSize;
+    e = e * 2.0f + Vector3f(0.1f);
+    boxes[i] = AABB(c - e, c + e);
+  }
+
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+  Bvh bvh;
+  const double build_1 = MeasureNsPerOp(3, [&]() {
+    bvh.Build(boxes.data(), boxes.size(), 1);
+  });
+  const double build_n = MeasureNsPerOp(3, [&]() {
+    bvh.Build(boxes.data(), boxes.size(), threads);
+  });
+  const double refit = MeasureNsPerOp(10, [&]() {
+    bvh.Refit(boxes.data());
+  });
+
+  Matrix4f proj, rotation, translation;
+  PersProjInfo persp = { 60.0f, 1920.0f, 1080.0f, 1.0f, 300.0f };
+  proj.InitPersProjTransform(persp);
+  rotation.InitCameraTransform(Vector3f(0.0f, 0.0f, 1.0f),
+                               Vector3f(0.0f, 1.0f, 0.0f));
+  translation.InitTranslationTransform(0.0f, 0.0f, 50.0f);
+  const Matrix4f view = rotation * translation;
+  Frustum frustum;
+  frustum.Extract(proj * view);
+
+  std::vector<u32> out;
+  out.reserve(kCount);
+
+  size_t frustum_hits = 0;
+  const double frustum_bvh = MeasureNsPerOp(20, [&]() {
+    out.clear();
+    bvh.QueryFrustum(frustum, out);
+    frustum_hits = out.size();
+  });
+  const double frustum_brute = MeasureNsPerOp(20, [&]() {
+    out.clear();
+    for (size_t i = 0; i < kCount; i++) {
+      if (frustum.IntersectsAABB(boxes[i].min, boxes[i].max)) {
+        out.push_back(static_cast<u32>(i));
+      }
+    }
+  });
+  const size_t frustum_expected = out.size();
+
+  const Vector3f center(10.0f, -20.0f, 30.0f);
+  const float radius = 50.0f;
+  size_t sphere_hits = 0;
+  const double sphere_bvh = MeasureNsPerOp(200, [&]() {
+    out.clear();
+    bvh.QuerySphere(center, radius, out);
+    sphere_hits = out.size();
+  });
+  const double sphere_brute = MeasureNsPerOp(20, [&]() {
+    out.clear();
+    for (size_t i = 0; i < kCount; i++) {
+      if (BoxOverlapsSphere(boxes[i], center, radius)) {
+        out.push_back(static_cast<u32>(i));
+      }
+    }
+  });
+  const size_t sphere_expected = out.size();
+
+  const Vector3f origin(-kWorldSize, 1.0f, 2.0f);
+  const Vector3f dir(1.0f, 0.01f, -0.02f);
+  size_t ray_hits = 0;
+  const double ray_bvh = MeasureNsPerOp(2000, [&]() {
+    out.clear();
+    bvh.QueryRay(origin, dir, 2.0f * kWorldSize, out);
+    ray_hits = out.size();
+  });
+  const Vector3f inv_dir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+  const double ray_brute = MeasureNsPerOp(20, [&]() {
+    out.clear();
+    for (size_t i = 0; i < kCount; i++) {
+      if (RayHitsBox(boxes[i], origin, inv_dir, 2.0f * kWorldSize)) {
+        out.push_back(static_cast<u32>(i));
+      }
+    }
+  });
+  const size_t ray_expected = out.size();
+
+  printf("%zu boxes, %zu nodes\n", kCount, bvh.node_count());
+  printf("%-28s %12.3f ms\n", "build, 1 thread", build_1 * 1e-6);
+  char label[32];
+  snprintf(label, sizeof(label), "build, %u threads", threads);
+  printf("%-28s %12.3f ms\n", label, build_n * 1e-6);
+  printf("%-28s %12.3f ms\n", "refit", refit * 1e-6);
+  printf("%-28s %12.1f us  (%zu hits)\n", "frustum query", frustum_bvh * 1e-3,
+         frustum_hits);
+  printf("%-28s %12.1f us  (%zu hits)\n", "frustum, brute force",
+         frustum_brute * 1e-3, frustum_expected);
+  printf("%-28s %12.1f us  (%zu hits)\n", "sphere query", sphere_bvh * 1e-3,
+         sphere_hits);
+  printf("%-28s %12.1f us  (%zu hits)\n", "sphere, brute force",
+         sphere_brute * 1e-3, sphere_expected);
+  printf("%-28s %12.1f us  (%zu hits)\n", "ray query", ray_bvh * 1e-3,
+         ray_hits);
+  printf("%-28s %12.1f us  (%zu hits)\n", "ray, brute force",
+         ray_brute * 1e-3, ray_expected);
+
+  return frustum_hits == frustum_expected && sphere_hits == sphere_expected &&
+                 ray_hits == ray_expected
+             ? 0
+             : 1;
+}
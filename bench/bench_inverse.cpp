@@ -0,0 +1,143 @@
+#include <cstdio>
+
+#include "bench_util.h"
+#include "ogldev_aligned.h"
+#include "ogldev_math_3d.h"
+
+// Compares the Matrix4f inverse paths on a batch of affine and rigid
+// transforms, as built by the tutorials.
+
+static const size_t kCount = 1024;
+static const size_t kIterations = 2000;
+
+// Inverse() as it was before the shared-cofactor rewrite: the 24-term
+// Determinant() followed by 16 independently expanded cofactors. Kept here
+// so that the speedups below are measured against it.
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+static void BaselineInverse(Matrix4f& matrix) {
+  const float (&m)[4][4] = matrix.m;
+  const float invdet = 1.0f / matrix.Determinant();
+
+  Matrix4f res;
+  res.m[0][0] = invdet * (m[1][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) +
+                          m[1][2] * (m[2][3] * m[3][1] - m[2][1] * m[3][3]) +
+                          m[1][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]));
+  res.m[0][1] = -invdet * (m[0][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) +
+                           m[0][2] * (m[2][3] * m[3][1] - m[2][1] * m[3][3]) +
+                           m[0][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]));
+  res.m[0][2] = invdet * (m[0][1] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) +
+                          m[0][2] * (m[1][3] * m[3][1] - m[1][1] * m[3][3]) +
+                          m[0][3] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]));
+  res.m[0][3] = -invdet * (m[0][1] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) +
+                           m[0][2] * (m[1][3] * m[2][1] - m[1][1] * m[2][3]) +
+                           m[0][3] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]));
+  res.m[1][0] = -invdet * (m[1][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) +
+                           m[1][2] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) +
+                           m[1][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]));
+  res.m[1][1] = invdet * (m[0][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) +
+                          m[0][2] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) +
+                          m[0][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]));
+  res.m[1][2] = -invdet * (m[0][0] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) +
+                           m[0][2] * (m[1][3] * m[3][0] - m[1][0] * m[3][3]) +
+                           m[0][3] * (m[1][0] * m[3][2] - m[1][2] * m[3][0]));
+  res.m[1][3] = invdet * (m[0][0] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) +
+                          m[0][2] * (m[1][3] * m[2][0] - m[1][0] * m[2][3]) +
+                          m[0][3] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]));
+  res.m[2][0] = invdet * (m[1][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) +
+                          m[1][1] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) +
+                          m[1][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
+  res.m[2][1] = -invdet * (m[0][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) +
+                           m[0][1] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) +
+                           m[0][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
+  res.m[2][2] = invdet * (m[0][0] * (m[1][1] * m[3][3] - m[1][3] * m[3][1]) +
+                          m[0][1] * (m[1][3] * m[3][0] - m[1][0] * m[3][3]) +
+                          m[0][3] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]));
+  res.m[2][3] = -invdet * (m[0][0] * (m[1][1] * m[2][3] - m[1][3] * m[2][1]) +
+                           m[0][1] * (m[1][3] * m[2][0] - m[1][0] * m[2][3]) +
+                           m[0][3] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]));
+  res.m[3][0] = -invdet * (m[1][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) +
+                           m[1][1] * (m[2][2] * m[3][0] - m[2][0] * m[3][2]) +
+                           m[1][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
+  res.m[3][1] = invdet * (m[0][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) +
+                          m[0][1] * (m[2][2] * m[3][0] - m[2][0] * m[3][2]) +
+                          m[0][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
+  res.m[3][2] = -invdet * (m[0][0] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]) +
+                           m[0][1] * (m[1][2] * m[3][0] - m[1][0] * m[3][2]) +
+                           m[0][2] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]));
+  res.m[3][3] = invdet * (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) +
+                          m[0][1] * (m[1][2] * m[2][0] - m[1][0] * m[2][2]) +
+                          m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]));
+  matrix = res;
+}
+
+int main() {
+  AlignedVector<Matrix4f> affine(kCount);
+  AlignedVector<Matrix4f> rigid(kCount);
+  AlignedVector<Matrix4f> out(kCount);
+
+  for (size_t i = 0; i < kCount; i++) {
+    Matrix4f s, r, t;
+    s.InitScaleTransform(1.0f + RandomFloat(), 1.0f + RandomFloat(),
+                         1.0f + RandomFloat());
+    r.InitRotateTransform(RandomFloat() * 360.0f, RandomFloat() * 360.0f,
+                          RandomFloat() * 360.0f);
+    t.InitTranslationTransform(RandomFloat() * 10.0f, RandomFloat() * 10.0f,
+                               RandomFloat() * 10.0f);
+    affine[i] = t * r * s;
+    rigid[i] = t * r;
+  }
+
+  double baseline = MeasureNsPerOp(kIterations, [&]() {
+    for (size_t i = 0; i < kCount; i++) {
+      out[i] = affine[i];
+      BaselineInverse(out[i]);
+    }
+    DoNotOptimize(out[0]);
+  });
+
+  double inverse = MeasureNsPerOp(kIterations, [&]() {
+    for (size_t i = 0; i < kCount; i++) {
+      out[i] = affine[i];
+      out[i].Inverse();
+    }
+    DoNotOptimize(out[0]);
+  });
+
+  double try_inverse = MeasureNsPerOp(kIterations, [&]() {
+    for (size_t i = 0; i < kCount; i++) {
+      affine[i].TryInverse(out[i]);
+    }
+    DoNotOptimize(out[0]);
+  });
+
+  double inverse_affine = MeasureNsPerOp(kIterations, [&]() {
+    for (size_t i = 0; i < kCount; i++) {
+      out[i] = affine[i];
+      out[i].InverseAffine();
+    }
+    DoNotOptimize(out[0]);
+  });
+
+  double inverse_rigid = MeasureNsPerOp(kIterations, [&]() {
+    for (size_t i = 0; i < kCount; i++) {
+      out[i] = rigid[i];
+      out[i].InverseRigid();
+    }
+    DoNotOptimize(out[0]);
+  });
+
+  printf("%-16s %10s %10s\n", "path", "ns/op", "speedup");
+  printf("%-16s %10.2f %10.2f\n", "baseline", baseline / kCount, 1.0);
+  printf("%-16s %10.2f %10.2f\n", "Inverse", inverse / kCount,
+         baseline / inverse);
+  printf("%-16s %10.2f %10.2f\n", "TryInverse", try_inverse / kCount,
+         baseline / try_inverse);
+  printf("%-16s %10.2f %10.2f\n", "InverseAffine", inverse_affine / kCount,
+         baseline / inverse_affine);
+  printf("%-16s %10.2f %10.2f\n", "InverseRigid", inverse_rigid / kCount,
+         baseline / inverse_rigid);
+
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "ogldev_aligned.h"
+#include "ogldev_math_3d.h"
+#include "ogldev_random.h"
+
+// Times the common math library over batches of inputs and writes the
+// results as JSON, to stdout or to the file named on the command line.
+// Each operation runs at a cache-resident and a larger-than-L2 batch size.
+
+static const size_t kBatchSizes[] = { 1024, 65536 };
+// Operations timed per benchmark, whatever the batch size.
+static const size_t kTotalOps = 1 << 22;
+
+static Matrix4f RandomTransform(Random& rng) {
+  Matrix4f m;
+  m.InitTRS(Vector3f(rng.NextFloat() * 10.0f, rng.NextFloat() * 10.0f,
+                     rng.NextFloat() * 10.0f),
+            Vector3f(rng.NextFloat() * 360.0f, rng.NextFloat() * 360.0f,
+                     rng.NextFloat() * 360.0f),
+            Vector3f(0.5f + rng.NextFloat(), 0.5f + rng.NextFloat(),
+                     0.5f + rng.NextFloat()));
+  return m;
+}
+
+static Quaternion RandomRotation(Random& rng) {
+  Quaternion q(rng.NextFloat() - 0.5f, rng.NextFloat() - 0.5f,
+               rng.NextFloat() - 0.5f, rng.NextFloat() - 0.5f);
+  q.Normalize();
+  return q;
+}
+
+static void BenchBatch(BenchReport& report, size_t n) {
+  Random rng(42);
+  const size_t iterations = kTotalOps / n;
+
+  AlignedVector<Matrix4f> a(n), b(n), m_out(n);
+  std::vector<Vector3f> u(n), v(n), v_out(n);
+  std::vector<Quaternion> p(n), q(n), q_out(n);
+  std::vector<float> f_out(n);
+  std::vector<PersProjInfo> proj(n);
+
+  rng.FillUniform(&u[0], n, Vector3f(-1.0f), Vector3f(1.0f));
+  rng.FillOnUnitSphere(&v[0], n);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = RandomTransform(rng);
+    b[i] = RandomTransform(rng);
+    p[i] = RandomRotation(rng);
+    q[i] = RandomRotation(rng);
+    proj[i].FOV = 30.0f + rng.NextFloat() * 60.0f;
+    proj[i].Width = 1920.0f;
+    proj[i].Height = 1080.0f;
+    proj[i].zNear = 0.1f + rng.NextFloat();
+    proj[i].zFar = 100.0f + rng.NextFloat() * 1000.0f;
+  }
+
+  report.Add("Matrix4f::operator*(Matrix4f)", n,
+             MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) m_out[i] = a[i] * b[i];
+               DoNotOptimize(m_out[0]);
+             }));
+
+  report.Add("Matrix4f::operator*(Vector4f)", n,
+             MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 const Vector4f p4(u[i].x, u[i].y, u[i].z, 1.0f);
+                 v_out[i] = (a[i] * p4).to3f();
+               }
+               DoNotOptimize(v_out[0]);
+             }));
+
+  report.Add("Matrix4f::Transpose", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) m_out[i] = a[i].Transpose();
+               DoNotOptimize(m_out[0]);
+             }));
+
+  report.Add("Matrix4f::Inverse", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 m_out[i] = a[i];
+                 m_out[i].Inverse();
+               }
+               DoNotOptimize(m_out[0]);
+             }));
+
+  report.Add("Matrix4f::InverseAffine", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 m_out[i] = a[i];
+                 m_out[i].InverseAffine();
+               }
+               DoNotOptimize(m_out[0]);
+             }));
+
+  report.Add("Matrix4f::Determinant", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) f_out[i] = a[i].Determinant();
+               DoNotOptimize(f_out[0]);
+             }));
+
+  report.Add("Matrix4f::InitPersProjTransform", n,
+             MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 m_out[i].InitPersProjTransform(proj[i]);
+               }
+               DoNotOptimize(m_out[0]);
+             }));
+
+  report.Add("Vector3f::Normalize", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 v_out[i] = u[i];
+                 v_out[i].Normalize();
+               }
+               DoNotOptimize(v_out[0]);
+             }));
+
+  report.Add("Vector3f::Cross", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) v_out[i] = u[i].Cross(v[i]);
+               DoNotOptimize(v_out[0]);
+             }));
+
+  report.Add("Vector3f::Rotate", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 v_out[i] = u[i];
+                 v_out[i].Rotate(proj[i].FOV, v[i]);
+               }
+               DoNotOptimize(v_out[0]);
+             }));
+
+  report.Add("Quaternion::operator*", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) q_out[i] = p[i] * q[i];
+               DoNotOptimize(q_out[0]);
+             }));
+
+  report.Add("Quaternion::Normalize", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 q_out[i] = p[i];
+                 q_out[i].Normalize();
+               }
+               DoNotOptimize(q_out[0]);
+             }));
+
+  report.Add("Nlerp", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 q_out[i] = Nlerp(p[i], q[i], 0.3f);
+               }
+               DoNotOptimize(q_out[0]);
+             }));
+
+  report.Add("Slerp", n, MeasureNsPerOp(iterations, [&]() {
+               for (size_t i = 0; i < n; i++) {
+                 q_out[i] = Slerp(p[i], q[i], 0.3f);
+               }
+               DoNotOptimize(q_out[0]);
+             }));
+}
+
+int main(int argc, char** argv) {
+  BenchReport report;
+  for (size_t n : kBatchSizes) {
+    BenchBatch(report, n);
+  }
+
+  FILE* f = stdout;
+  if (argc > 1) {
+    f = fopen(argv[1], "w");
+    if (!f) {
+      fprintf(stderr, "Error opening '%s'\n", argv[1]);
+      return 1;
+    }
+  }
+
+  report.WriteJson(f);
+
+  if (f != stdout) {
+    fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "bench_util.h"
+#include "ogldev_mesh_loader.h"
+#include "ogldev_util.h"
+
+#ifdef OGLDEV_HAVE_ASSIMP
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#endif
+
+// Loads a large OBJ file with LoadObj() on one thread and on all threads,
+// the same mesh as a binary PLY with LoadPly(), and, when built with
+// assimp, the OBJ with assimp's importer and the post-processing flags the
+// tutorials use for meshes.
+//
+//   bench_mesh_load [dir] [grid]
+//
+// The mesh is a |grid| x |grid| quad grid with positions, texture
+// coordinates and normals (default 1500: about 300MB of OBJ). The files
+// are written to |dir| (default: current directory) and removed afterwards.
+
+static void Append(std::string& s, const char* format, ...) {
+  char line[96];
+  va_list args;
+  va_start(args, format);
+  const int n = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  s.append(line, n);
+}
+
+static bool WriteObj(const std::string& path, int grid) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+
+  std::string text;
+  const int side = grid + 1;
+  for (int y = 0; y < side; y++) {
+    for (int x = 0; x < side; x++) {
+      const double h = 0.25 * sin(x * 0.05) * cos(y * 0.07);
+      Append(text, "v %.6f %.6f %.6f\n", x * 0.01, h, y * 0.01);
+      Append(text, "vt %.6f %.6f\n", double(x) / grid, double(y) / grid);
+      Append(text, "vn %.6f %.6f %.6f\n", 0.0, 1.0, 0.0);
+    }
+    fwrite(text.data(), 1, text.size(), f);
+    text.clear();
+  }
+  for (int y = 0; y < grid; y++) {
+    for (int x = 0; x < grid; x++) {
+      const int a = y * side + x + 1;
+      const int b = a + 1;
+      const int c = a + side + 1;
+      const int d = a + side;
+      Append(text, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b,
+             b, c, c, c, d, d, d);
+    }
+    fwrite(text.data(), 1, text.size(), f);
+    text.clear();
+  }
+  return fclose(f) == 0;
+}
+
+static bool WritePly(const std::string& path, const MeshData& mesh) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+
+  fprintf(f,
+          "ply\nformat binary_little_endian 1.0\n"
+          "element vertex %zu\n"
+          "property float x\nproperty float y\nproperty float z\n"
+          "property float u\nproperty float v\n"
+          "property float nx\nproperty float ny\nproperty float nz\n"
+          "element face %zu\n"
+          "property list uchar uint vertex_indices\n"
+          "end_header\n",
+          mesh.vertices.size(), mesh.indices.size() / 3);
+  fwrite(mesh.vertices.data(), sizeof(MeshVertex), mesh.vertices.size(), f);
+  for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+    const unsigned char n = 3;
+    fwrite(&n, 1, 1, f);
+    fwrite(&mesh.indices[i], sizeof(u32), 3, f);
+  }
+  return fclose(f) == 0;
+}
+
+static long FileSize(const std::string& path) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) {
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fclose(f);
+  return size;
+}
+
+// Milliseconds for one call of |fn|, best of three.
+template <typename Fn>
+static double BestMs(Fn fn) {
+  double best = 1e30;
+  for (int i = 0; i < 3; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(
+        best, std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  const std::string dir = argc > 1 ? argv[1] : ".";
+  const int grid = argc > 2 ? std::max(1, atoi(argv[2])) : 1500;
+  const unsigned threads =
+      std::max(1u, std::thread::hardware_concurrency());
+
+  const std::string obj = dir + "/bench_mesh_load.obj";
+  const std::string ply = dir + "/bench_mesh_load.ply";
+  if (!WriteObj(obj, grid)) {
+    fprintf(stderr, "Cannot write %s\n", obj.c_str());
+    return 1;
+  }
+
+  MeshData mesh;
+  if (!LoadObj(obj.c_str(), mesh) || !WritePly(ply, mesh)) {
+    remove(obj.c_str());
+    return 1;
+  }
+  printf("%zu vertices, %zu triangles, OBJ %.1fMB, PLY %.1fMB\n",
+         mesh.vertices.size(), mesh.indices.size() / 3,
+         FileSize(obj) / 1048576.0, FileSize(ply) / 1048576.0);
+
+  const double mb = FileSize(obj) / 1048576.0;
+  printf("%-28s %10s %10s\n", "loader", "ms", "MB/s");
+
+  const double obj_single = BestMs([&]() {
+    LoadObj(obj.c_str(), mesh, 1);
+    DoNotOptimize(mesh.indices.back());
+  });
+  printf("%-28s %10.1f %10.1f\n", "LoadObj 1 thread", obj_single,
+         mb / (obj_single * 1e-3));
+
+  const double obj_all = BestMs([&]() {
+    LoadObj(obj.c_str(), mesh, threads);
+    DoNotOptimize(mesh.indices.back());
+  });
+  char name[64];
+  snprintf(name, sizeof(name), "LoadObj %u threads", threads);
+  printf("%-28s %10.1f %10.1f\n", name, obj_all, mb / (obj_all * 1e-3));
+
+  const double ply_all = BestMs([&]() {
+    LoadPly(ply.c_str(), mesh, threads);
+    DoNotOptimize(mesh.indices.back());
+  });
+  printf("%-28s %10.1f %10s\n", "LoadPly binary", ply_all, "-");
+
+#ifdef OGLDEV_HAVE_ASSIMP
+  const double assimp = BestMs([&]() {
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(obj.c_str(), ASSIMP_LOAD_FLAGS);
+    DoNotOptimize(scene);
+  });
+  printf("%-28s %10.1f %10.1f\n", "assimp", assimp, mb / (assimp * 1e-3));
+#endif
+
+  remove(obj.c_str());
+  remove(ply.c_str());
+  return 0;
+}
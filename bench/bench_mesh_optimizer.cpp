@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "ogldev_mesh_optimizer.h"
+
+// Runs the index buffer pipeline on a shuffled grid (the worst case for
+// the post-transform cache) or on a mesh file, and prints the FIFO cache
+// statistics after each step with the time it took.
+//
+//   bench_mesh_optimizer [mesh.obj|mesh.ply|grid size]
+
+struct GridVertex {
+  Vector3f pos;
+  Vector3f normal;
+};
+
+// An unindexed triangle list, the way the tutorials draw, with the
+// triangles in random order.
+static std::vector<GridVertex> ShuffledGrid(int grid) {
+  std::vector<GridVertex> corners;
+  for (int y = 0; y < grid; y++) {
+    for (int x = 0; x < grid; x++) {
+      GridVertex v[4];
+      for (int k = 0; k < 4; k++) {
+        v[k].pos = Vector3f(float(x + (k == 1 || k == 2)), 0.0f,
+                            float(y + (k >= 2)));
+        v[k].normal = Vector3f(0.0f, 1.0f, 0.0f);
+      }
+      const int order[6] = {0, 1, 2, 0, 2, 3};
+      for (int k : order) corners.push_back(v[k]);
+    }
+  }
+
+  std::mt19937 rng(1);
+  const size_t triangle_count = corners.size() / 3;
+  for (size_t t = triangle_count - 1; t > 0; t--) {
+    const size_t other = rng() % (t + 1);
+    for (int k = 0; k < 3; k++) {
+      std::swap(corners[t * 3 + k], corners[other * 3 + k]);
+    }
+  }
+  return corners;
+}
+
+static void Print(const char* step, const std::vector<u32>& indices,
+                  size_t vertex_count, double ms) {
+  const u32 kSizes[] = {16, 32};
+  printf("%-22s", step);
+  for (u32 size : kSizes) {
+    const VertexCacheStats s = AnalyzeVertexCache(
+        indices.data(), indices.size(), vertex_count, size);
+    printf(" %8.3f %8.3f", s.acmr, s.atvr);
+  }
+  printf(" %10.1f\n", ms);
+}
+
+template <typename Fn>
+static double TimeMs(Fn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Vertex>
+static void Optimize(std::vector<Vertex>& vertices,
+                     std::vector<u32>& indices) {
+  const double cache_ms = TimeMs([&]() {
+    OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+  });
+  Print("cache order", indices, vertices.size(), cache_ms);
+
+  const double fetch_ms = TimeMs([&]() {
+    OptimizeVertexFetch(indices.data(), indices.size(), vertices);
+  });
+  Print("fetch order", indices, vertices.size(), fetch_ms);
+}
+
+int main(int argc, char** argv) {
+  const char* arg = argc > 1 ? argv[1] : "500";
+
+  printf("%-22s %8s %8s %8s %8s %10s\n", "", "ACMR/16", "ATVR/16",
+         "ACMR/32", "ATVR/32", "ms");
+
+  if (atoi(arg) > 0) {
+    const std::vector<GridVertex> corners = ShuffledGrid(atoi(arg));
+    printf("%zu triangles\n", corners.size() / 3);
+
+    // Unindexed drawing transforms every corner.
+    printf("%-22s %8.3f %8s %8.3f %8s %10s\n", "glDrawArrays", 3.0, "-",
+           3.0, "-", "-");
+
+    std::vector<GridVertex> vertices;
+    std::vector<u32> indices;
+    const double weld_ms = TimeMs([&]() {
+      GenerateIndexBuffer(corners.data(), corners.size(), vertices, indices);
+    });
+    Print("welded, input order", indices, vertices.size(), weld_ms);
+    Optimize(vertices, indices);
+  } else {
+    MeshData mesh;
+    if (!LoadMesh(arg, mesh)) {
+      return 1;
+    }
+    printf("%zu triangles\n", mesh.indices.size() / 3);
+    Print("file order", mesh.indices, mesh.vertices.size(), 0.0);
+    Optimize(mesh.vertices, mesh.indices);
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench_util.h"
+#include "ogldev_profiler.h"
+#include "ogldev_util.h"
+
+// Measures the cost of the clock and of profiling zones, disabled and
+// recording, then writes the recorded zones as a Chrome trace.
+//
+//   bench_profiler [trace.json]
+
+static const size_t kIterations = 1000000;
+
+static u64 g_sum = 0;
+
+static void Work() {
+  g_sum += g_sum * 31 + 7;
+}
+
+int main(int argc, char** argv) {
+  const char* trace_file = argc > 1 ? argv[1] : "bench_profiler_trace.json";
+  ProfilerSetThreadName("bench_profiler");
+
+  const double clock_ns = MeasureNsPerOp(kIterations, []() {
+    const u64 t = GetTimeNs();
+    DoNotOptimize(t);
+  });
+  const double base_ns = MeasureNsPerOp(kIterations, []() { Work(); });
+  const double off_ns = MeasureNsPerOp(kIterations, []() {
+    OGLDEV_PROFILE_SCOPE("Work");
+    Work();
+  });
+
+  ProfilerStart();
+  const double on_ns = MeasureNsPerOp(kIterations, []() {
+    OGLDEV_PROFILE_SCOPE("Work");
+    Work();
+  });
+  ProfilerStop();
+  DoNotOptimize(g_sum);
+
+  printf("%-24s %8.1f ns\n", "GetTimeNs", clock_ns);
+  printf("%-24s %8.1f ns\n", "zone, not recording", off_ns - base_ns);
+  printf("%-24s %8.1f ns\n", "zone, recording", on_ns - base_ns);
+
+  const u64 start = GetTimeNs();
+  if (!WriteChromeTrace(trace_file)) {
+    return 1;
+  }
+  printf("trace written to %s in %.1f ms\n", trace_file,
+         (GetTimeNs() - start) / 1e6);
+  return 0;
+}
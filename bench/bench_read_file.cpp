@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "bench_util.h"
+#include "ogldev_mapped_file.h"
+#include "ogldev_util.h"
+
+// Reads text files from shader size to large asset size with the old
+// getline loop, ReadFile() into a string and the mapping ReadFile()
+// overload. The files are written to the directory given on the command
+// line (default: current directory) and removed afterwards. They are in
+// the page cache, so this measures copying and allocation, not the disk.
+
+static const size_t kSizes[] = { 1 << 10, 64 << 10, 1 << 20, 16 << 20,
+                                 100 << 20 };
+// Bytes read per measurement, whatever the file size.
+static const size_t kBytesPerRun = 512 << 20;
+
+// What ReadFile() did before: one getline() and two appends per line.
+static bool ReadFileByLine(const char* file_name, std::string& out) {
+  std::ifstream f(file_name);
+  if (!f.is_open()) {
+    return false;
+  }
+
+  std::string line;
+  while (getline(f, line)) {
+    out.append(line);
+    out.append("\n");
+  }
+  return true;
+}
+
+static void WriteTestFile(const std::string& path, size_t size) {
+  static const char kLine[] =
+      "vec3 n = normalize(normal_matrix * in_normal); // lighting\n";
+
+  std::string text;
+  text.reserve(size);
+  while (text.size() < size) {
+    text.append(kLine, std::min(sizeof(kLine) - 1, size - text.size()));
+  }
+
+  FILE* f = fopen(path.c_str(), "wb");
+  fwrite(text.data(), 1, text.size(), f);
+  fclose(f);
+}
+
+int main(int argc, char** argv) {
+  const std::string dir = argc > 1 ? argv[1] : ".";
+
+  printf("%10s %14s %14s %14s\n", "size", "getline MB/s", "string MB/s",
+         "mapped MB/s");
+
+  for (size_t size : kSizes) {
+    const std::string path = dir + "/bench_read_file.tmp";
+    WriteTestFile(path, size);
+    const size_t iterations = std::max<size_t>(3, kBytesPerRun / size);
+
+    const double by_line = MeasureNsPerOp(iterations, [&]() {
+      std::string s;
+      ReadFileByLine(path.c_str(), s);
+      DoNotOptimize(s[s.size() / 2]);
+    });
+
+    const double whole = MeasureNsPerOp(iterations, [&]() {
+      std::string s;
+      ReadFile(path.c_str(), s);
+      DoNotOptimize(s[s.size() / 2]);
+    });
+
+    // Touches one byte per page so that the mapping is actually faulted in.
+    const double mapped = MeasureNsPerOp(iterations, [&]() {
+      MappedFile file;
+      ReadFile(path.c_str(), file);
+      unsigned sum = 0;
+      for (size_t i = 0; i < file.size(); i += 4096) {
+        sum += static_cast<unsigned char>(file.data()[i]);
+      }
+      DoNotOptimize(sum);
+    });
+
+    remove(path.c_str());
+
+    const double mb = static_cast<double>(size) / (1 << 20);
+    printf("%8zuKB %14.1f %14.1f %14.1f\n", size >> 10, mb / (by_line * 1e-9),
+           mb / (whole * 1e-9), mb / (mapped * 1e-9));
+  }
+
+  return 0;
+}
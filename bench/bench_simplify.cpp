@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "ogldev_simplify.h"
+
+// Builds LOD chains for a bumpy sphere, prints the triangle count and error
+// of each level and checks that it is still manifold, then times
+// BuildLodChains() over several copies of the sphere on one thread and on
+// all threads. Exits with 1 if a LOD is not manifold.
+//
+//   bench_simplify [rings] [meshes]
+
+static const float kRatios[] = {1.0f, 0.5f, 0.25f, 0.125f, 0.0625f, 0.01f};
+static const size_t kRatioCount = sizeof(kRatios) / sizeof(kRatios[0]);
+
+static void BumpySphere(int rings, std::vector<Vector3f>& positions,
+                        std::vector<u32>& indices) {
+  const int segments = rings * 2;
+  positions.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  for (int r = 1; r < rings; r++) {
+    for (int s = 0; s < segments; s++) {
+      const float theta = static_cast<float>(M_PI) * r / rings;
+      const float phi = 2.0f * static_cast<float>(M_PI) * s / segments;
+      const float radius = 1.0f + 0.02f * sinf(8 * phi) * sinf(6 * theta);
+      positions.push_back(Vector3f(radius * sinf(theta) * cosf(phi),
+                                   radius * cosf(theta),
+                                   radius * sinf(theta) * sinf(phi)));
+    }
+  }
+  positions.push_back(Vector3f(0.0f, -1.0f, 0.0f));
+
+  const u32 bottom = static_cast<u32>(positions.size() - 1);
+  auto id = [segments](int r, int s) {
+    return static_cast<u32>(1 + (r - 1) * segments + s % segments);
+  };
+  for (int s = 0; s < segments; s++) {
+    indices.insert(indices.end(), {0, id(1, s + 1), id(1, s)});
+    indices.insert(indices.end(),
+                   {bottom, id(rings - 1, s), id(rings - 1, s + 1)});
+  }
+  for (int r = 1; r < rings - 1; r++) {
+    for (int s = 0; s < segments; s++) {
+      const u32 a = id(r, s);
+      const u32 b = id(r, s + 1);
+      const u32 c = id(r + 1, s + 1);
+      const u32 d = id(r + 1, s);
+      indices.insert(indices.end(), {a, b, c, a, c, d});
+    }
+  }
+}
+
+// True if no directed edge is used twice. The sphere is closed and
+// consistently oriented, so a doubled edge means two triangles were folded
+// onto each other or the surface was pinched.
+static bool IsManifold(const std::vector<u32>& indices) {
+  std::vector<u64> edges;
+  edges.reserve(indices.size());
+  for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+    for (int k = 0; k < 3; k++) {
+      edges.push_back(static_cast<u64>(indices[t + k]) << 32 |
+                      indices[t + (k + 1) % 3]);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+  return std::adjacent_find(edges.begin(), edges.end()) == edges.end();
+}
+
+template <typename Fn>
+static double TimeMs(Fn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+  const int rings = argc > 1 ? std::max(4, atoi(argv[1])) : 100;
+  const size_t mesh_count = argc > 2 ? std::max(1, atoi(argv[2])) : 8;
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<Vector3f> positions;
+  std::vector<u32> indices;
+  BumpySphere(rings, positions, indices);
+
+  std::vector<MeshLod> lods;
+  const double ms = TimeMs([&]() {
+    BuildLodChain(indices.data(), indices.size(), positions.data(),
+                  positions.size(), kRatios, kRatioCount, lods);
+  });
+  printf("%zu triangles, chain built in %.1f ms\n", indices.size() / 3, ms);
+  printf("%5s %10s %10s %9s\n", "lod", "triangles", "error", "manifold");
+  bool manifold = true;
+  for (size_t i = 0; i < lods.size(); i++) {
+    const bool ok = IsManifold(lods[i].indices);
+    printf("%5zu %10zu %10.5f %9s\n", i, lods[i].indices.size() / 3,
+           lods[i].error, ok ? "yes" : "NO");
+    manifold = manifold && ok;
+  }
+
+  std::vector<LodMeshInput> meshes(
+      mesh_count,
+      {indices.data(), indices.size(), positions.data(), positions.size()});
+  std::vector<std::vector<MeshLod>> chains;
+  const unsigned thread_counts[] = {1, threads};
+  for (unsigned t : thread_counts) {
+    const double chains_ms = TimeMs([&]() {
+      BuildLodChains(meshes.data(), meshes.size(), kRatios, kRatioCount,
+                     chains, t);
+    });
+    printf("%zu meshes on %u thread(s): %.1f ms\n", mesh_count, t, chains_ms);
+    DoNotOptimize(chains.back().back().error);
+  }
+  return manifold ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away a value computed in a benchmark.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T* sink;
+  sink = &value;
+#endif
+}
+
+// Calls |fn| |iterations| times and returns the average time per call in
+// nanoseconds. One untimed call warms up caches first.
+template <typename Fn>
+double MeasureNsPerOp(size_t iterations, Fn fn) {
+  fn();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++) {
+    fn();
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double ns =
+      std::chrono::duration<double, std::nano>(end - start).count();
+  return ns / iterations;
+}
+
+// Collects benchmark results and writes them as JSON, one record per
+// operation and batch size:
+//
+//   {"benchmarks": [{"name": "...", "batch": 1024, "ns_per_op": 1.5,
+//                    "ops_per_sec": 666666666.7}, ...]}
+class BenchReport {
+ public:
+  // |ns_per_batch| is the time for one pass over |batch| operations.
+  void Add(const std::string& name, size_t batch, double ns_per_batch) {
+    Result r;
+    r.name = name;
+    r.batch = batch;
+    r.ns_per_op = ns_per_batch / batch;
+    results_.push_back(r);
+  }
+
+  void WriteJson(FILE* f) const {
+    fprintf(f, "{\"benchmarks\": [");
+    for (size_t i = 0; i < results_.size(); i++) {
+      const Result& r = results_[i];
+      fprintf(f,
+              "%s\n  {\"name\": \"%s\", \"batch\": %zu, "
+              "\"ns_per_op\": %.4f, \"ops_per_sec\": %.1f}",
+              i == 0 ? "" : ",", r.name.c_str(), r.batch, r.ns_per_op,
+              1e9 / r.ns_per_op);
+    }
+    fprintf(f, "\n]}\n");
+  }
+
+ private:
+  struct Result {
+    std::string name;
+    size_t batch;
+    double ns_per_op;
+  };
+
+  std::vector<Result> results_;
+};
+
+#endif  // BENCH_UTIL_H_
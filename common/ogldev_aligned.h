@@ -0,0 +1,135 @@
+#ifndef OGLDEV_ALIGNED_H
+#define OGLDEV_ALIGNED_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+#ifdef WIN32
+#include <malloc.h>
+#endif
+
+// Size of a cache line on the platforms we care about. Bulk buffers of math
+// types are aligned to it, so that e.g. every Matrix4f (64 bytes) sits in
+// exactly one cache line.
+static const size_t kCacheLineSize = 64;
+
+// Allocates |size| bytes aligned to |alignment| (a power of two, at least
+// sizeof(void*)). Returns NULL on failure. Release with AlignedFree().
+inline void* AlignedMalloc(size_t size, size_t alignment) {
+#ifdef WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void* p = NULL;
+  if (posix_memalign(&p, alignment, size) != 0) {
+    return NULL;
+  }
+  return p;
+#endif
+}
+
+inline void AlignedFree(void* p) {
+#ifdef WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+// Standard allocator returning memory aligned to |Alignment| bytes (or to
+// alignof(T) if that is larger).
+template <typename T, size_t Alignment = kCacheLineSize>
+class AlignedAllocator {
+ public:
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two");
+  static_assert(Alignment >= sizeof(void*),
+                "Alignment must be at least sizeof(void*)");
+
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind {
+    typedef AlignedAllocator<U, Alignment> other;
+  };
+
+  AlignedAllocator() {}
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+  T* allocate(size_t n) {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+    const size_t align = Alignment > alignof(T) ? Alignment : alignof(T);
+    void* p = AlignedMalloc(n * sizeof(T), align);
+    if (p == NULL) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t) { AlignedFree(p); }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) {
+  return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) {
+  return false;
+}
+
+// Contiguous, cache-line aligned array of math types, e.g.
+// AlignedVector<Matrix4f> for a buffer of world matrices that is processed
+// with SIMD and uploaded with glBufferData.
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+
+// Gives a class an operator new/delete that honors its alignas(), which
+// plain operator new does not guarantee before C++17. Class-scope
+// operator new hides every global form, so the placement and nothrow forms
+// are declared too.
+#define OGLDEV_ALIGNOF_NEW(Type) \
+  (alignof(Type) > sizeof(void*) ? alignof(Type) : sizeof(void*))
+
+#define OGLDEV_ALIGNED_OPERATOR_NEW(Type)                                   \
+  static void* operator new(size_t size) {                                  \
+    void* p = AlignedMalloc(size, OGLDEV_ALIGNOF_NEW(Type));                \
+    if (p == NULL) throw std::bad_alloc();                                  \
+    return p;                                                               \
+  }                                                                         \
+  static void* operator new[](size_t size) {                                \
+    void* p = AlignedMalloc(size, OGLDEV_ALIGNOF_NEW(Type));                \
+    if (p == NULL) throw std::bad_alloc();                                  \
+    return p;                                                               \
+  }                                                                         \
+  static void operator delete(void* p) { AlignedFree(p); }                  \
+  static void operator delete[](void* p) { AlignedFree(p); }                \
+  static void* operator new(size_t size, const std::nothrow_t&) noexcept {  \
+    return AlignedMalloc(size, OGLDEV_ALIGNOF_NEW(Type));                   \
+  }                                                                         \
+  static void* operator new[](size_t size,                                  \
+                              const std::nothrow_t&) noexcept {             \
+    return AlignedMalloc(size, OGLDEV_ALIGNOF_NEW(Type));                   \
+  }                                                                         \
+  static void operator delete(void* p, const std::nothrow_t&) noexcept {    \
+    AlignedFree(p);                                                         \
+  }                                                                         \
+  static void operator delete[](void* p, const std::nothrow_t&) noexcept {  \
+    AlignedFree(p);                                                         \
+  }                                                                         \
+  static void* operator new(size_t, void* where) noexcept { return where; } \
+  static void* operator new[](size_t, void* where) noexcept {               \
+    return where;                                                           \
+  }                                                                         \
+  static void operator delete(void*, void*) noexcept {}                     \
+  static void operator delete[](void*, void*) noexcept {}
+
+#endif  // OGLDEV_ALIGNED_H
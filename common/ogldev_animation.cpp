@@ -0,0 +1,195 @@
+#include "ogldev_animation.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ogldev_simd.h"
+
+void KeyframeAnimation::Channel::AddTrack(const float* key_times,
+                                          const float* key_values,
+                                          size_t stride, size_t count) {
+  assert(count > 0);
+
+  first_key.push_back(static_cast<u32>(times.size()));
+  key_count.push_back(static_cast<u32>(count));
+  cursor.push_back(0);
+
+  for (size_t k = 0; k < count; k++) {
+    assert(k == 0 || key_times[k] > key_times[k - 1]);
+    times.push_back(key_times[k]);
+    for (int c = 0; c < components; c++) {
+      values[c].push_back(key_values[k * stride + c]);
+    }
+  }
+}
+
+void KeyframeAnimation::Channel::Locate(float time, size_t padded_count) {
+  const size_t count = first_key.size();
+
+  lo.resize(padded_count);
+  hi.resize(padded_count);
+  frac.resize(padded_count);
+
+  for (size_t i = 0; i < count; i++) {
+    const u32 first = first_key[i];
+    const u32 n = key_count[i];
+    const float* t = &times[first];
+
+    if (n == 1 || time <= t[0]) {
+      lo[i] = hi[i] = first;
+      frac[i] = 0.0f;
+      continue;
+    }
+    if (time >= t[n - 1]) {
+      lo[i] = hi[i] = first + n - 1;
+      frac[i] = 0.0f;
+      continue;
+    }
+
+    // Find k with t[k] <= time < t[k + 1]. Try the pair used last time and
+    // the next one before falling back to a binary search.
+    u32 k = cursor[i];
+    if (!(k + 1 < n && t[k] <= time && time < t[k + 1])) {
+      if (k + 2 < n && t[k + 1] <= time && time < t[k + 2]) {
+        k++;
+      } else {
+        k = static_cast<u32>(std::upper_bound(t, t + n, time) - t) - 1;
+      }
+    }
+    cursor[i] = k;
+
+    lo[i] = first + k;
+    hi[i] = first + k + 1;
+    frac[i] = (time - t[k]) / (t[k + 1] - t[k]);
+  }
+
+  // Padding tracks interpolate key 0 with itself.
+  for (size_t i = count; i < padded_count; i++) {
+    lo[i] = hi[i] = 0;
+    frac[i] = 0.0f;
+  }
+}
+
+void KeyframeAnimation::Channel::Gather(size_t padded_count) {
+  for (int c = 0; c < components; c++) {
+    a[c].resize(padded_count);
+    b[c].resize(padded_count);
+
+    const float* v = values[c].data();
+    for (size_t i = 0; i < padded_count; i++) {
+      a[c][i] = v[lo[i]];
+      b[c][i] = v[hi[i]];
+    }
+  }
+}
+
+KeyframeAnimation::KeyframeAnimation()
+    : joint_count_(0), translation_(3), rotation_(4), scale_(3) {}
+
+size_t KeyframeAnimation::AddJoint(
+    const float* translation_times, const Vector3f* translations,
+    size_t translation_count, const float* rotation_times,
+    const Quaternion* rotations, size_t rotation_count,
+    const float* scale_times, const Vector3f* scales, size_t scale_count) {
+  translation_.AddTrack(translation_times, &translations[0].x,
+                        sizeof(Vector3f) / sizeof(float), translation_count);
+  rotation_.AddTrack(rotation_times, &rotations[0].x,
+                     sizeof(Quaternion) / sizeof(float), rotation_count);
+  scale_.AddTrack(scale_times, &scales[0].x, sizeof(Vector3f) / sizeof(float),
+                  scale_count);
+
+  return joint_count_++;
+}
+
+void KeyframeAnimation::Sample(float time, Vector3f* translations,
+                               Quaternion* rotations, Vector3f* scales) {
+  const size_t padded_count = (joint_count_ + 3) & ~static_cast<size_t>(3);
+
+  Channel* channels[3] = {&translation_, &rotation_, &scale_};
+  for (int i = 0; i < 3; i++) {
+    channels[i]->Locate(time, padded_count);
+    channels[i]->Gather(padded_count);
+  }
+
+  Lerp3(translation_, padded_count, translations);
+  Nlerp4(rotation_, padded_count, rotations);
+  Lerp3(scale_, padded_count, scales);
+}
+
+void KeyframeAnimation::Lerp3(Channel& c, size_t padded_count,
+                              Vector3f* out) {
+  float* r[3] = {c.a[0].data(), c.a[1].data(), c.a[2].data()};
+
+  for (size_t i = 0; i < padded_count; i += 4) {
+    const simd::Float4 f = simd::Load4A(&c.frac[i]);
+    for (int k = 0; k < 3; k++) {
+      const simd::Float4 va = simd::Load4A(r[k] + i);
+      const simd::Float4 vb = simd::Load4A(&c.b[k][i]);
+      simd::Store4A(r[k] + i,
+                    simd::Add4(va, simd::Mul4(simd::Sub4(vb, va), f)));
+    }
+  }
+
+  size_t i = 0;
+  for (; i + 4 <= joint_count_; i += 4) {
+    simd::StoreInterleave3(&out[i].x, simd::Load4A(r[0] + i),
+                           simd::Load4A(r[1] + i), simd::Load4A(r[2] + i));
+  }
+  for (; i < joint_count_; i++) {
+    out[i] = Vector3f(r[0][i], r[1][i], r[2][i]);
+  }
+}
+
+void KeyframeAnimation::Nlerp4(Channel& c, size_t padded_count,
+                               Quaternion* out) {
+  float* r[4] = {c.a[0].data(), c.a[1].data(), c.a[2].data(), c.a[3].data()};
+
+  for (size_t i = 0; i < padded_count; i += 4) {
+    const simd::Float4 f = simd::Load4A(&c.frac[i]);
+
+    simd::Float4 va[4];
+    simd::Float4 vb[4];
+    for (int k = 0; k < 4; k++) {
+      va[k] = simd::Load4A(r[k] + i);
+      vb[k] = simd::Load4A(&c.b[k][i]);
+    }
+
+    simd::Float4 dot = simd::Mul4(va[0], vb[0]);
+    for (int k = 1; k < 4; k++) {
+      dot = simd::Add4(dot, simd::Mul4(va[k], vb[k]));
+    }
+
+    // Shortest arc, then lerp and normalize.
+    simd::Float4 q[4];
+    for (int k = 0; k < 4; k++) {
+      const simd::Float4 b = simd::FlipSign4(vb[k], dot);
+      q[k] = simd::Add4(va[k], simd::Mul4(simd::Sub4(b, va[k]), f));
+    }
+
+    simd::Float4 len2 = simd::Mul4(q[0], q[0]);
+    for (int k = 1; k < 4; k++) {
+      len2 = simd::Add4(len2, simd::Mul4(q[k], q[k]));
+    }
+    const simd::Float4 len = simd::Sqrt4(len2);
+
+    for (int k = 0; k < 4; k++) {
+      simd::Store4A(r[k] + i, simd::Div4(q[k], len));
+    }
+  }
+
+  size_t i = 0;
+  for (; i + 4 <= joint_count_; i += 4) {
+    simd::Float4 x = simd::Load4A(r[0] + i);
+    simd::Float4 y = simd::Load4A(r[1] + i);
+    simd::Float4 z = simd::Load4A(r[2] + i);
+    simd::Float4 w = simd::Load4A(r[3] + i);
+    simd::Transpose4(x, y, z, w);
+    simd::Store4(&out[i + 0].x, x);
+    simd::Store4(&out[i + 1].x, y);
+    simd::Store4(&out[i + 2].x, z);
+    simd::Store4(&out[i + 3].x, w);
+  }
+  for (; i < joint_count_; i++) {
+    out[i] = Quaternion(r[0][i], r[1][i], r[2][i], r[3][i]);
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef OGLDEV_ANIMATION_H
+#define OGLDEV_ANIMATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_aligned.h"
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Keyframe animation of many joints, each with a translation, rotation and
+// scale track.
+//
+// The keys of all joints are stored channel by channel as structure of
+// arrays (times[], x[], y[], z[], w[]), and Sample() evaluates every joint
+// for one time in two passes: a scalar pass that locates the key pair of
+// each track (starting from the pair used last time, so playback is O(1)
+// per track), and a SIMD pass that interpolates four joints at a time.
+// Translations and scales are lerped, rotations are nlerped along the
+// shortest arc (see Nlerp()).
+//
+// Sample() keeps per-track cursors and scratch buffers, so one instance must
+// not be sampled from several threads at once.
+class KeyframeAnimation {
+ public:
+  KeyframeAnimation();
+
+  // Adds a joint and returns its index. Every track needs at least one key
+  // and its times must be increasing. Times outside a track clamp to its
+  // first or last key.
+  size_t AddJoint(const float* translation_times, const Vector3f* translations,
+                  size_t translation_count, const float* rotation_times,
+                  const Quaternion* rotations, size_t rotation_count,
+                  const float* scale_times, const Vector3f* scales,
+                  size_t scale_count);
+
+  size_t joint_count() const { return joint_count_; }
+
+  // Evaluates all joints at |time|. Each output array must hold
+  // joint_count() elements.
+  void Sample(float time, Vector3f* translations, Quaternion* rotations,
+              Vector3f* scales);
+
+ private:
+  // All tracks of one property, keys of track i at
+  // [first_key[i], first_key[i] + key_count[i]).
+  struct Channel {
+    explicit Channel(int components) : components(components) {}
+
+    void AddTrack(const float* times, const float* values, size_t stride,
+                  size_t count);
+
+    // Fills lo/hi/frac for every track.
+    void Locate(float time, size_t padded_count);
+
+    // Gathers the key pairs into the a/b scratch lanes.
+    void Gather(size_t padded_count);
+
+    int components;
+    std::vector<u32> first_key;
+    std::vector<u32> key_count;
+    std::vector<u32> cursor;
+    std::vector<float> times;
+    std::vector<float> values[4];
+
+    // Per-track scratch, padded to a multiple of 4 tracks.
+    std::vector<u32> lo;
+    std::vector<u32> hi;
+    AlignedVector<float> frac;
+    AlignedVector<float> a[4];
+    AlignedVector<float> b[4];
+  };
+
+  void Lerp3(Channel& c, size_t padded_count, Vector3f* out);
+  void Nlerp4(Channel& c, size_t padded_count, Quaternion* out);
+
+  size_t joint_count_;
+  Channel translation_;
+  Channel rotation_;
+  Channel scale_;
+};
+
+#endif  // OGLDEV_ANIMATION_H
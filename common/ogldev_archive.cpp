@@ -0,0 +1,284 @@
+#include "ogldev_archive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ogldev_compress.h"
+#include "ogldev_util.h"
+
+static_assert(sizeof(ArchiveHeader) == 48, "ArchiveHeader has padding");
+static_assert(sizeof(ArchiveEntry) == 48, "ArchiveEntry has padding");
+
+u64 ArchiveHash(const char* name, size_t length) {
+  u64 h = 14695981039346656037ull;
+  for (size_t i = 0; i < length; i++) {
+    h ^= static_cast<u8>(name[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+// About one entry per bucket.
+static u32 BucketBits(size_t entry_count) {
+  u32 bits = 0;
+  while ((size_t(1) << bits) < entry_count) bits++;
+  return bits;
+}
+
+static u32 BucketOf(u64 hash, u32 bucket_bits) {
+  return bucket_bits == 0 ? 0 : static_cast<u32>(hash >> (64 - bucket_bits));
+}
+
+static u64 AlignUp(u64 v, u64 alignment) {
+  return (v + alignment - 1) / alignment * alignment;
+}
+
+// Whether [offset, offset + length) lies within a file of |size| bytes,
+// without adding the untrusted values.
+static bool InFile(u64 offset, u64 length, u64 size) {
+  return offset <= size && length <= size - offset;
+}
+
+void ArchiveWriter::Add(const std::string& name, const char* data,
+                        size_t size, bool compress) {
+  Pending p;
+  p.name = name;
+  p.hash = ArchiveHash(name.data(), name.size());
+  p.size = size;
+  p.compression = kCompressionNone;
+
+  if (compress && size > 0) {
+    p.stored.resize(CompressBound(size));
+    const size_t compressed = Compress(data, size, &p.stored[0]);
+    if (compressed <= size - size / 8) {
+      p.stored.resize(compressed);
+      p.compression = kCompressionLz4;
+    }
+  }
+  if (p.compression == kCompressionNone) {
+    p.stored.assign(data, size);
+  }
+
+  entries_.push_back(std::move(p));
+}
+
+bool ArchiveWriter::Write(const char* fileName) const {
+  std::vector<const Pending*> sorted;
+  for (const Pending& p : entries_) {
+    sorted.push_back(&p);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Pending* a, const Pending* b) {
+              return a->hash != b->hash ? a->hash < b->hash
+                                        : a->name < b->name;
+            });
+  for (size_t i = 1; i < sorted.size(); i++) {
+    if (sorted[i]->name == sorted[i - 1]->name) {
+      OGLDEV_ERROR("Duplicate archive entry '%s'\n", sorted[i]->name.c_str());
+      return false;
+    }
+  }
+
+  ArchiveHeader header;
+  memcpy(header.magic, kArchiveMagic, sizeof(header.magic));
+  header.version = kArchiveVersion;
+  header.entry_count = static_cast<u32>(sorted.size());
+  header.bucket_bits = BucketBits(sorted.size());
+
+  const size_t bucket_count = size_t(1) << header.bucket_bits;
+  std::vector<u32> buckets(bucket_count + 1, 0);
+  for (const Pending* p : sorted) {
+    buckets[BucketOf(p->hash, header.bucket_bits) + 1]++;
+  }
+  for (size_t b = 0; b < bucket_count; b++) {
+    buckets[b + 1] += buckets[b];
+  }
+
+  std::string names;
+  for (const Pending* p : sorted) {
+    names += p->name;
+  }
+
+  header.buckets_offset = sizeof(ArchiveHeader);
+  header.index_offset =
+      AlignUp(header.buckets_offset + buckets.size() * sizeof(u32), 8);
+  header.names_offset =
+      header.index_offset + sorted.size() * sizeof(ArchiveEntry);
+  header.names_size = names.size();
+
+  std::vector<ArchiveEntry> index(sorted.size());
+  u64 offset = AlignUp(header.names_offset + names.size(), kBlobAlignment);
+  u32 name_offset = 0;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    ArchiveEntry& e = index[i];
+    memset(&e, 0, sizeof(e));
+    e.hash = sorted[i]->hash;
+    e.offset = offset;
+    e.stored_size = sorted[i]->stored.size();
+    e.size = sorted[i]->size;
+    e.name_offset = name_offset;
+    e.name_size = static_cast<u32>(sorted[i]->name.size());
+    e.compression = sorted[i]->compression;
+    name_offset += e.name_size;
+    offset = AlignUp(offset + e.stored_size, kBlobAlignment);
+  }
+
+  FILE* f = fopen(fileName, "wb");
+  if (!f) {
+    OGLDEV_FILE_ERROR(fileName);
+    return false;
+  }
+
+  // Writes |size| bytes and pads to |end|.
+  u64 pos = 0;
+  auto write = [f, &pos](const void* data, size_t size, u64 end) {
+    static const char kZeros[kBlobAlignment] = {0};
+    bool ok = size == 0 || fwrite(data, size, 1, f) == 1;
+    pos += size;
+    while (ok && pos < end) {
+      const size_t n = static_cast<size_t>(
+          std::min<u64>(end - pos, sizeof(kZeros)));
+      ok = fwrite(kZeros, n, 1, f) == 1;
+      pos += n;
+    }
+    return ok;
+  };
+
+  bool ok = write(&header, sizeof(header), header.buckets_offset) &&
+            write(buckets.data(), buckets.size() * sizeof(u32),
+                  header.index_offset) &&
+            write(index.data(), index.size() * sizeof(ArchiveEntry),
+                  header.names_offset) &&
+            write(names.data(), names.size(),
+                  index.empty() ? 0 : index[0].offset);
+  for (size_t i = 0; ok && i < sorted.size(); i++) {
+    const u64 end = i + 1 < index.size() ? index[i + 1].offset : 0;
+    ok = write(sorted[i]->stored.data(), sorted[i]->stored.size(), end);
+  }
+
+  if (fclose(f) != 0) {
+    ok = false;
+  }
+  if (!ok) {
+    OGLDEV_ERROR("Error writing '%s'\n", fileName);
+  }
+  return ok;
+}
+
+void AssetArchive::Close() {
+  file_.Close();
+  header_ = NULL;
+  buckets_ = NULL;
+  index_ = NULL;
+  names_ = NULL;
+}
+
+bool AssetArchive::Open(const char* fileName) {
+  Close();
+  if (!file_.Open(fileName, MappedFile::kAccessRandom)) {
+    return false;
+  }
+
+  const u64 size = file_.size();
+  const char* base = file_.data();
+  const ArchiveHeader* h = reinterpret_cast<const ArchiveHeader*>(base);
+
+  bool ok = size >= sizeof(ArchiveHeader) &&
+            memcmp(h->magic, kArchiveMagic, sizeof(h->magic)) == 0 &&
+            h->version == kArchiveVersion && h->bucket_bits < 32;
+  if (ok) {
+    const u64 bucket_count = u64(1) << h->bucket_bits;
+    ok = h->buckets_offset % sizeof(u32) == 0 &&
+         InFile(h->buckets_offset, (bucket_count + 1) * sizeof(u32), size) &&
+         h->index_offset % 8 == 0 &&
+         InFile(h->index_offset, u64(h->entry_count) * sizeof(ArchiveEntry),
+                size) &&
+         InFile(h->names_offset, h->names_size, size);
+  }
+  if (ok) {
+    buckets_ = reinterpret_cast<const u32*>(base + h->buckets_offset);
+    index_ = reinterpret_cast<const ArchiveEntry*>(base + h->index_offset);
+    names_ = base + h->names_offset;
+    const u64 bucket_count = u64(1) << h->bucket_bits;
+    ok = buckets_[0] == 0 && buckets_[bucket_count] == h->entry_count;
+    for (u64 b = 0; ok && b < bucket_count; b++) {
+      ok = buckets_[b] <= buckets_[b + 1];
+    }
+  }
+  // LZ4 expands at most about 255:1, which bounds the sizes that a
+  // corrupt entry can make Read() allocate.
+  for (u32 i = 0; ok && i < h->entry_count; i++) {
+    const ArchiveEntry& e = index_[i];
+    const bool sizes_ok =
+        e.compression == kCompressionNone
+            ? e.stored_size == e.size
+            : e.compression == kCompressionLz4 && e.size / 256 <= e.stored_size;
+    ok = InFile(e.offset, e.stored_size, size) &&
+         u64(e.name_offset) + e.name_size <= h->names_size && sizes_ok;
+  }
+
+  if (!ok) {
+    OGLDEV_ERROR("'%s' is not a valid asset archive\n", fileName);
+    Close();
+    return false;
+  }
+
+  header_ = h;
+  return true;
+}
+
+const ArchiveEntry* AssetArchive::Find(const char* name) const {
+  if (!header_) {
+    return NULL;
+  }
+
+  const size_t length = strlen(name);
+  const u64 hash = ArchiveHash(name, length);
+  const u32 bucket = BucketOf(hash, header_->bucket_bits);
+
+  for (u32 i = buckets_[bucket]; i < buckets_[bucket + 1]; i++) {
+    const ArchiveEntry& e = index_[i];
+    if (e.hash == hash && e.name_size == length &&
+        memcmp(names_ + e.name_offset, name, length) == 0) {
+      return &e;
+    }
+  }
+  return NULL;
+}
+
+FileSpan AssetArchive::View(const ArchiveEntry& e) const {
+  if (e.compression != kCompressionNone) {
+    FileSpan empty = { NULL, 0 };
+    return empty;
+  }
+  return file_.span(static_cast<size_t>(e.offset),
+                    static_cast<size_t>(e.stored_size));
+}
+
+bool AssetArchive::Read(const ArchiveEntry& e, std::string& out) const {
+  const FileSpan stored = file_.span(static_cast<size_t>(e.offset),
+                                     static_cast<size_t>(e.stored_size));
+
+  if (e.compression == kCompressionNone) {
+    out.assign(stored.data, stored.size);
+    return true;
+  }
+
+  out.resize(static_cast<size_t>(e.size));
+  if (!Decompress(stored.data, stored.size, &out[0], out.size())) {
+    OGLDEV_ERROR("Corrupt archive entry '%s'\n", name(e).c_str());
+    out.clear();
+    return false;
+  }
+  return true;
+}
+
+bool AssetArchive::Read(const char* name, std::string& out) const {
+  const ArchiveEntry* e = Find(name);
+  if (!e) {
+    OGLDEV_ERROR("No archive entry '%s'\n", name);
+    return false;
+  }
+  return Read(*e, out);
+}
@@ -0,0 +1,122 @@
+#ifndef OGLDEV_ARCHIVE_H
+#define OGLDEV_ARCHIVE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ogldev_mapped_file.h"
+#include "ogldev_types.h"
+
+// Single-file asset archive, read through a memory mapping.
+//
+// Layout, little-endian:
+//
+//   ArchiveHeader
+//   u32 buckets[bucket_count + 1]   first index entry of each hash bucket
+//   ArchiveEntry index[entry_count] sorted by hash
+//   char names[names_size]          entry names, not terminated
+//   blobs                           each kBlobAlignment aligned
+//
+// A lookup hashes the name, takes the bucket from the top hash bits and
+// scans its few entries, so it costs no system call and is O(1) on
+// average. Each entry is stored raw or LZ4-compressed (ogldev_compress.h);
+// raw entries can be used in place without a copy.
+//
+// Names are relative paths with '/' separators, e.g. "04_shaders/shader.vs".
+
+static const char kArchiveMagic[4] = { 'O', 'G', 'P', 'K' };
+static const u32 kArchiveVersion = 1;
+static const u32 kBlobAlignment = 16;
+
+enum ArchiveCompression : u32 {
+  kCompressionNone = 0,
+  kCompressionLz4 = 1,
+};
+
+struct ArchiveHeader {
+  char magic[4];
+  u32 version;
+  u32 entry_count;
+  u32 bucket_bits;
+  u64 buckets_offset;
+  u64 index_offset;
+  u64 names_offset;
+  u64 names_size;
+};
+
+struct ArchiveEntry {
+  u64 hash;
+  u64 offset;
+  u64 stored_size;
+  u64 size;
+  u32 name_offset;
+  u32 name_size;
+  u32 compression;
+  u32 reserved;
+};
+
+// FNV-1a of the name.
+u64 ArchiveHash(const char* name, size_t length);
+
+// Collects files in memory and writes them as an archive.
+class ArchiveWriter {
+ public:
+  // Adds an entry. With |compress| the data is stored compressed if that
+  // saves at least an eighth of its size.
+  void Add(const std::string& name, const char* data, size_t size,
+           bool compress);
+
+  // Reports errors with OGLDEV_ERROR, including duplicate names.
+  bool Write(const char* fileName) const;
+
+ private:
+  struct Pending {
+    std::string name;
+    std::string stored;
+    u64 hash;
+    u64 size;
+    ArchiveCompression compression;
+  };
+
+  std::vector<Pending> entries_;
+};
+
+// Reads an archive written by ArchiveWriter.
+class AssetArchive {
+ public:
+  AssetArchive() : header_(NULL), buckets_(NULL), index_(NULL), names_(NULL) {}
+
+  // Maps the archive and validates every entry. Reports errors with
+  // OGLDEV_ERROR.
+  bool Open(const char* fileName);
+  void Close();
+
+  size_t entry_count() const { return header_ ? header_->entry_count : 0; }
+  const ArchiveEntry& entry(size_t i) const { return index_[i]; }
+  std::string name(const ArchiveEntry& e) const {
+    return std::string(names_ + e.name_offset, e.name_size);
+  }
+
+  // NULL if there is no such entry.
+  const ArchiveEntry* Find(const char* name) const;
+
+  // The stored bytes of a raw entry, valid while the archive is open.
+  // Empty for a compressed entry; use Read() for those.
+  FileSpan View(const ArchiveEntry& e) const;
+
+  // Replaces |out| with the contents of the entry, decompressing it if
+  // needed.
+  bool Read(const ArchiveEntry& e, std::string& out) const;
+  // Find() then Read(). Reports a missing entry with OGLDEV_ERROR.
+  bool Read(const char* name, std::string& out) const;
+
+ private:
+  MappedFile file_;
+  const ArchiveHeader* header_;
+  const u32* buckets_;
+  const ArchiveEntry* index_;
+  const char* names_;
+};
+
+#endif  // OGLDEV_ARCHIVE_H
@@ -0,0 +1,128 @@
+#include "ogldev_async_loader.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "ogldev_profiler.h"
+
+AsyncLoader::AsyncLoader(unsigned thread_count)
+    : stop_(false), tail_(new Job()), pending_(0) {
+  tail_->ok = false;
+  tail_->next.store(NULL, std::memory_order_relaxed);
+  head_.store(tail_, std::memory_order_relaxed);
+
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned i = 0; i < thread_count; i++) {
+    workers_.emplace_back(&AsyncLoader::WorkerLoop, this);
+  }
+}
+
+AsyncLoader::~AsyncLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    for (Job* job : queue_) {
+      delete job;
+    }
+    queue_.clear();
+  }
+  cond_.notify_all();
+  for (std::thread& t : workers_) {
+    t.join();
+  }
+
+  while (Job* job = PopCompleted()) {
+    delete job;
+  }
+  delete tail_;
+}
+
+void AsyncLoader::Load(const std::string& path, DecodeFn decode,
+                       DoneFn done) {
+  Job* job = new Job();
+  job->path = path;
+  job->decode = std::move(decode);
+  job->done = std::move(done);
+  job->ok = false;
+  job->next.store(NULL, std::memory_order_relaxed);
+
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(job);
+  }
+  cond_.notify_one();
+}
+
+void AsyncLoader::WorkerLoop() {
+  ProfilerSetThreadName("AsyncLoader");
+  for (;;) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      job = queue_.front();
+      queue_.pop_front();
+    }
+
+    OGLDEV_PROFILE_SCOPE("AsyncLoader::Job");
+    MappedFile file;
+    job->ok = file.Open(job->path.c_str(), MappedFile::kAccessSequential);
+    if (job->ok && job->decode) {
+      OGLDEV_PROFILE_SCOPE("AsyncLoader::Decode");
+      job->ok = job->decode(file);
+    }
+    // The decoder is done with whatever it captured.
+    job->decode = DecodeFn();
+
+    PushCompleted(job);
+  }
+}
+
+void AsyncLoader::PushCompleted(Job* job) {
+  job->next.store(NULL, std::memory_order_relaxed);
+  Job* prev = head_.exchange(job, std::memory_order_acq_rel);
+  // Between the exchange and this store the consumer sees the queue end at
+  // |prev|, which only delays |job| to the next Poll().
+  prev->next.store(job, std::memory_order_release);
+}
+
+// Returns the oldest finished job, now owned by the caller, or NULL. The
+// popped job's successor in the list becomes the new stub, so the job
+// returned is the old stub refilled with the successor's result.
+AsyncLoader::Job* AsyncLoader::PopCompleted() {
+  Job* stub = tail_;
+  Job* next = stub->next.load(std::memory_order_acquire);
+  if (next == NULL) {
+    return NULL;
+  }
+
+  stub->path = std::move(next->path);
+  stub->done = std::move(next->done);
+  stub->ok = next->ok;
+  tail_ = next;
+  return stub;
+}
+
+size_t AsyncLoader::Poll(size_t max_callbacks) {
+  size_t count = 0;
+  while (count < max_callbacks) {
+    Job* job = PopCompleted();
+    if (job == NULL) {
+      break;
+    }
+
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    if (job->done) {
+      job->done(job->ok);
+    }
+    delete job;
+    count++;
+  }
+  return count;
+}
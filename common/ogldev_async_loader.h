@@ -0,0 +1,96 @@
+#ifndef OGLDEV_ASYNC_LOADER_H
+#define OGLDEV_ASYNC_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ogldev_mapped_file.h"
+
+// Loads files on a pool of background threads and hands the results back
+// to one thread, normally the GL thread.
+//
+// Each load maps the file, runs |decode| on a loader thread and queues the
+// |done| callback. Poll(), called once per frame, runs the queued
+// callbacks. Anything that needs the GL context (shader compilation,
+// buffer uploads) belongs in |done|; parsing and decompression belong in
+// |decode|. The two share data through whatever they capture:
+//
+//   auto text = std::make_shared<std::string>();
+//   loader.Load("shader.vs",
+//               [text](const MappedFile& f) {
+//                 text->assign(f.data(), f.size());
+//                 return true;
+//               },
+//               [text](bool ok) {
+//                 if (ok) CompileShader(*text);
+//               });
+//
+// Finished loads travel through a lock-free queue, so Poll() never waits
+// for a loader thread.
+class AsyncLoader {
+ public:
+  // Runs on a loader thread. The file is closed when it returns. Returns
+  // false if the contents are unusable.
+  typedef std::function<bool(const MappedFile& file)> DecodeFn;
+  // Runs in Poll(). |ok| is false if the file could not be opened or
+  // |decode| failed.
+  typedef std::function<void(bool ok)> DoneFn;
+
+  // |thread_count| 0 means one thread per hardware thread.
+  explicit AsyncLoader(unsigned thread_count = 0);
+  // Drops the loads that have not started, waits for the running ones and
+  // discards all undelivered results without calling |done|.
+  ~AsyncLoader();
+
+  AsyncLoader(const AsyncLoader&) = delete;
+  AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+  // Queues a load. |decode| may be empty.
+  void Load(const std::string& path, DecodeFn decode, DoneFn done);
+
+  // Runs the |done| callbacks of up to |max_callbacks| finished loads, in
+  // completion order, and returns how many ran. Must always be called from
+  // the same thread.
+  size_t Poll(size_t max_callbacks = static_cast<size_t>(-1));
+
+  // Loads queued but not yet delivered by Poll().
+  size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Job {
+    std::string path;
+    DecodeFn decode;
+    DoneFn done;
+    bool ok;
+    std::atomic<Job*> next;
+  };
+
+  void WorkerLoop();
+
+  // Multi-producer single-consumer queue of finished jobs (Vyukov). head_
+  // is the most recently pushed job; tail_ is a stub that precedes the
+  // oldest one and is only touched by the consumer.
+  void PushCompleted(Job* job);
+  Job* PopCompleted();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Job*> queue_;
+  bool stop_;
+
+  std::atomic<Job*> head_;
+  Job* tail_;
+
+  std::atomic<size_t> pending_;
+};
+
+#endif  // OGLDEV_ASYNC_LOADER_H
@@ -0,0 +1,388 @@
+#include "ogldev_bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <thread>
+
+// Number of centroid bins per split.
+static const int kBinCount = 16;
+// Leaves never hold more primitives than this, whatever the SAH says.
+static const u32 kMaxLeafSize = 8;
+// Cost of visiting a node relative to testing one primitive.
+static const float kTraversalCost = 1.0f;
+// Subtrees smaller than this are never handed to another thread.
+static const u32 kMinParallelCount = 4096;
+// Depth limit, so queries can use a fixed-size stack.
+static const int kMaxDepth = 64;
+
+static float Axis(const Vector3f& v, int axis) {
+  return (&v.x)[axis];
+}
+
+AABB AABB::Empty() {
+  return AABB(Vector3f(FLT_MAX), Vector3f(-FLT_MAX));
+}
+
+void AABB::Grow(const Vector3f& p) {
+  min = Vector3f(std::min(min.x, p.x), std::min(min.y, p.y),
+                 std::min(min.z, p.z));
+  max = Vector3f(std::max(max.x, p.x), std::max(max.y, p.y),
+                 std::max(max.z, p.z));
+}
+
+void AABB::Grow(const AABB& b) {
+  min = Vector3f(std::min(min.x, b.min.x), std::min(min.y, b.min.y),
+                 std::min(min.z, b.min.z));
+  max = Vector3f(std::max(max.x, b.max.x), std::max(max.y, b.max.y),
+                 std::max(max.z, b.max.z));
+}
+
+float AABB::SurfaceArea() const {
+  const Vector3f e = max - min;
+  if (e.x < 0.0f) return 0.0f;
+  return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+}
+
+struct Bvh::BuildContext {
+  const AABB* boxes;
+  std::vector<Vector3f> centroids;
+  std::atomic<u32> next_node;
+  int parallel_depth;
+};
+
+void Bvh::Build(const AABB* boxes, size_t count, unsigned thread_count) {
+  nodes_.clear();
+  prims_.resize(count);
+  prim_boxes_.clear();
+  if (count == 0) {
+    return;
+  }
+
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  BuildContext ctx;
+  ctx.boxes = boxes;
+  ctx.centroids.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    prims_[i] = static_cast<u32>(i);
+    ctx.centroids[i] = boxes[i].Center();
+  }
+
+  // Each split hands one subtree to a new thread until there are about
+  // |thread_count| of them.
+  ctx.parallel_depth = 0;
+  while ((1u << ctx.parallel_depth) < thread_count) ctx.parallel_depth++;
+
+  // A binary tree over n leaves has at most 2n - 1 nodes. Node 1 is left
+  // unused so that sibling pairs start on even indices, i.e. on cache line
+  // boundaries.
+  nodes_.resize(2 * count + 1);
+  ctx.next_node = 2;
+  BuildNode(ctx, 0, 0, static_cast<u32>(count), 0);
+  nodes_.resize(std::max<u32>(ctx.next_node, 1));
+
+  prim_boxes_.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    prim_boxes_[i] = boxes[prims_[i]];
+  }
+}
+
+void Bvh::BuildNode(BuildContext& ctx, u32 node_index, u32 first, u32 count,
+                    int depth) {
+  Node& node = nodes_[node_index];
+  u32* prims = &prims_[first];
+
+  AABB bounds = AABB::Empty();
+  AABB centroid_bounds = AABB::Empty();
+  for (u32 i = 0; i < count; i++) {
+    bounds.Grow(ctx.boxes[prims[i]]);
+    centroid_bounds.Grow(ctx.centroids[prims[i]]);
+  }
+
+  node.min = bounds.min;
+  node.max = bounds.max;
+  node.index = first;
+  node.count = count;
+
+  if (count <= 2 || depth >= kMaxDepth - 1) {
+    return;
+  }
+
+  // Split along the axis with the largest centroid extent.
+  const Vector3f extent = centroid_bounds.max - centroid_bounds.min;
+  int axis = 0;
+  if (extent.y > Axis(extent, axis)) axis = 1;
+  if (extent.z > Axis(extent, axis)) axis = 2;
+
+  const float cmin = Axis(centroid_bounds.min, axis);
+  const float cextent = Axis(extent, axis);
+  if (cextent <= 0.0f) {
+    // All centroids coincide. Split in the middle so that leaves stay small.
+    if (count > kMaxLeafSize) {
+      SplitChildren(ctx, node, first, count / 2, count, depth);
+    }
+    return;
+  }
+
+  const float scale = kBinCount * (1.0f - 1e-5f) / cextent;
+  struct Bin {
+    AABB bounds;
+    u32 count;
+  } bins[kBinCount];
+  for (int b = 0; b < kBinCount; b++) {
+    bins[b].bounds = AABB::Empty();
+    bins[b].count = 0;
+  }
+
+  for (u32 i = 0; i < count; i++) {
+    const int b = std::min(
+        kBinCount - 1,
+        static_cast<int>((Axis(ctx.centroids[prims[i]], axis) - cmin) * scale));
+    bins[b].bounds.Grow(ctx.boxes[prims[i]]);
+    bins[b].count++;
+  }
+
+  // Sweep from the right to get the cost of every right side, then from
+  // the left to evaluate each split plane.
+  float right_area[kBinCount];
+  u32 right_count[kBinCount];
+  AABB acc = AABB::Empty();
+  u32 n = 0;
+  for (int b = kBinCount - 1; b > 0; b--) {
+    acc.Grow(bins[b].bounds);
+    n += bins[b].count;
+    right_area[b] = acc.SurfaceArea();
+    right_count[b] = n;
+  }
+
+  float best_cost = FLT_MAX;
+  int best_split = -1;
+  acc = AABB::Empty();
+  n = 0;
+  for (int b = 0; b < kBinCount - 1; b++) {
+    acc.Grow(bins[b].bounds);
+    n += bins[b].count;
+    if (n == 0 || right_count[b + 1] == 0) continue;
+
+    const float cost =
+        acc.SurfaceArea() * n + right_area[b + 1] * right_count[b + 1];
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_split = b;
+    }
+  }
+
+  const float area = bounds.SurfaceArea();
+  const float split_cost =
+      kTraversalCost + (area > 0.0f ? best_cost / area : 0.0f);
+  if (best_split < 0) {
+    if (count > kMaxLeafSize) {
+      SplitChildren(ctx, node, first, count / 2, count, depth);
+    }
+    return;
+  }
+  if (split_cost >= count && count <= kMaxLeafSize) {
+    return;
+  }
+
+  u32* mid = std::partition(prims, prims + count, [&](u32 p) {
+    const int b = std::min(
+        kBinCount - 1,
+        static_cast<int>((Axis(ctx.centroids[p], axis) - cmin) * scale));
+    return b <= best_split;
+  });
+  SplitChildren(ctx, node, first, static_cast<u32>(mid - prims), count,
+                depth);
+}
+
+void Bvh::SplitChildren(BuildContext& ctx, Node& node, u32 first,
+                        u32 left_count, u32 count, int depth) {
+  const u32 left = ctx.next_node.fetch_add(2);
+  node.index = left;
+  node.count = 0;
+
+  if (depth < ctx.parallel_depth && count >= kMinParallelCount) {
+    std::thread worker([&ctx, this, left, first, left_count, depth]() {
+      BuildNode(ctx, left, first, left_count, depth + 1);
+    });
+    BuildNode(ctx, left + 1, first + left_count, count - left_count,
+              depth + 1);
+    worker.join();
+  } else {
+    BuildNode(ctx, left, first, left_count, depth + 1);
+    BuildNode(ctx, left + 1, first + left_count, count - left_count,
+              depth + 1);
+  }
+}
+
+void Bvh::Refit(const AABB* boxes) {
+  for (size_t i = 0; i < prims_.size(); i++) {
+    prim_boxes_[i] = boxes[prims_[i]];
+  }
+
+  // Children are always allocated after their parent, so a reverse sweep
+  // visits them first. Node 1 is the unused padding slot.
+  for (size_t i = nodes_.size(); i-- > 0;) {
+    if (i == 1) continue;
+
+    Node& node = nodes_[i];
+    AABB bounds = AABB::Empty();
+    if (node.IsLeaf()) {
+      for (u32 k = 0; k < node.count; k++) {
+        bounds.Grow(prim_boxes_[node.index + k]);
+      }
+    } else {
+      const Node& l = nodes_[node.index];
+      const Node& r = nodes_[node.index + 1];
+      bounds.Grow(AABB(l.min, l.max));
+      bounds.Grow(AABB(r.min, r.max));
+    }
+    node.min = bounds.min;
+    node.max = bounds.max;
+  }
+}
+
+void Bvh::AppendSubtree(u32 node_index, std::vector<u32>& out) const {
+  // The primitives of a subtree are contiguous in prims_, from its
+  // leftmost to its rightmost leaf.
+  u32 lo = node_index;
+  while (!nodes_[lo].IsLeaf()) lo = nodes_[lo].index;
+  u32 hi = node_index;
+  while (!nodes_[hi].IsLeaf()) hi = nodes_[hi].index + 1;
+
+  out.insert(out.end(), prims_.begin() + nodes_[lo].index,
+             prims_.begin() + nodes_[hi].index + nodes_[hi].count);
+}
+
+void Bvh::QueryFrustum(const Frustum& frustum, std::vector<u32>& out) const {
+  if (nodes_.empty()) return;
+
+  u32 stack[kMaxDepth];
+  int sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const u32 index = stack[--sp];
+    const Node& node = nodes_[index];
+
+    // Per plane, the corners furthest along and against the normal decide
+    // between outside, crossing and fully inside.
+    bool inside = true;
+    bool outside = false;
+    for (int k = 0; k < Frustum::kPlaneCount && !outside; k++) {
+      const Plane& p = frustum.plane(k);
+      const Vector3f far_corner(p.n.x >= 0.0f ? node.max.x : node.min.x,
+                                p.n.y >= 0.0f ? node.max.y : node.min.y,
+                                p.n.z >= 0.0f ? node.max.z : node.min.z);
+      const Vector3f near_corner(p.n.x >= 0.0f ? node.min.x : node.max.x,
+                                 p.n.y >= 0.0f ? node.min.y : node.max.y,
+                                 p.n.z >= 0.0f ? node.min.z : node.max.z);
+      if (p.Distance(far_corner) < 0.0f) outside = true;
+      if (p.Distance(near_corner) < 0.0f) inside = false;
+    }
+
+    if (outside) continue;
+
+    if (inside) {
+      AppendSubtree(index, out);
+    } else if (node.IsLeaf()) {
+      for (u32 k = 0; k < node.count; k++) {
+        const AABB& b = prim_boxes_[node.index + k];
+        if (frustum.IntersectsAABB(b.min, b.max)) {
+          out.push_back(prims_[node.index + k]);
+        }
+      }
+    } else {
+      stack[sp++] = node.index + 1;
+      stack[sp++] = node.index;
+    }
+  }
+}
+
+static bool BoxOverlapsSphere(const Vector3f& min, const Vector3f& max,
+                              const Vector3f& c, float radius) {
+  const float dx = std::max(std::max(min.x - c.x, 0.0f), c.x - max.x);
+  const float dy = std::max(std::max(min.y - c.y, 0.0f), c.y - max.y);
+  const float dz = std::max(std::max(min.z - c.z, 0.0f), c.z - max.z);
+  return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+void Bvh::QuerySphere(const Vector3f& center, float radius,
+                      std::vector<u32>& out) const {
+  if (nodes_.empty()) return;
+
+  u32 stack[kMaxDepth];
+  int sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const Node& node = nodes_[stack[--sp]];
+    if (!BoxOverlapsSphere(node.min, node.max, center, radius)) continue;
+
+    if (node.IsLeaf()) {
+      for (u32 k = 0; k < node.count; k++) {
+        const AABB& b = prim_boxes_[node.index + k];
+        if (BoxOverlapsSphere(b.min, b.max, center, radius)) {
+          out.push_back(prims_[node.index + k]);
+        }
+      }
+    } else {
+      stack[sp++] = node.index + 1;
+      stack[sp++] = node.index;
+    }
+  }
+}
+
+// Slab test of the ray against [min, max], for 0 <= t <= t_max.
+static bool RayHitsBox(const Vector3f& min, const Vector3f& max,
+                       const Vector3f& origin, const Vector3f& inv_dir,
+                       float t_max) {
+  const float tx0 = (min.x - origin.x) * inv_dir.x;
+  const float tx1 = (max.x - origin.x) * inv_dir.x;
+  const float ty0 = (min.y - origin.y) * inv_dir.y;
+  const float ty1 = (max.y - origin.y) * inv_dir.y;
+  const float tz0 = (min.z - origin.z) * inv_dir.z;
+  const float tz1 = (max.z - origin.z) * inv_dir.z;
+
+  const float t_enter = std::max(
+      std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+      std::max(std::min(tz0, tz1), 0.0f));
+  const float t_exit = std::min(
+      std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+      std::min(std::max(tz0, tz1), t_max));
+
+  return t_enter <= t_exit;
+}
+
+void Bvh::QueryRay(const Vector3f& origin, const Vector3f& dir, float t_max,
+                   std::vector<u32>& out) const {
+  if (nodes_.empty()) return;
+
+  // Division by a zero component gives +-inf, which the slab test handles.
+  const Vector3f inv_dir(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+
+  u32 stack[kMaxDepth];
+  int sp = 0;
+  stack[sp++] = 0;
+
+  while (sp > 0) {
+    const Node& node = nodes_[stack[--sp]];
+    if (!RayHitsBox(node.min, node.max, origin, inv_dir, t_max)) continue;
+
+    if (node.IsLeaf()) {
+      for (u32 k = 0; k < node.count; k++) {
+        const AABB& b = prim_boxes_[node.index + k];
+        if (RayHitsBox(b.min, b.max, origin, inv_dir, t_max)) {
+          out.push_back(prims_[node.index + k]);
+        }
+      }
+    } else {
+      stack[sp++] = node.index + 1;
+      stack[sp++] = node.index;
+    }
+  }
+}
@@ -0,0 +1,98 @@
+#ifndef OGLDEV_BVH_H
+#define OGLDEV_BVH_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_aligned.h"
+#include "ogldev_frustum.h"
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Axis-aligned bounding box.
+struct AABB {
+  Vector3f min;
+  Vector3f max;
+
+  AABB() {}
+  AABB(const Vector3f& lo, const Vector3f& hi) : min(lo), max(hi) {}
+
+  // A box that contains nothing; Grow() it to add points or boxes.
+  static AABB Empty();
+
+  void Grow(const Vector3f& p);
+  void Grow(const AABB& b);
+
+  Vector3f Center() const { return (min + max) * 0.5f; }
+  float SurfaceArea() const;
+};
+
+// Bounding volume hierarchy over a set of primitives given by their boxes.
+//
+// The tree is built top-down with a binned surface area heuristic, the top
+// levels in parallel on several threads. Nodes live in one flat,
+// cache-line aligned array; the two children of a node are adjacent and
+// share a 64-byte line. Refit() updates the boxes of moving primitives
+// without rebuilding the topology.
+//
+// Queries return the indices of the primitives whose boxes pass the test;
+// the caller does any exact test on the primitives themselves.
+class Bvh {
+ public:
+  Bvh() {}
+
+  // Builds the tree over |count| boxes. |thread_count| 0 means one thread
+  // per hardware thread.
+  void Build(const AABB* boxes, size_t count, unsigned thread_count = 0);
+
+  // Updates the boxes of the primitives (same count and order as the last
+  // Build()) and all node bounds, bottom-up. Quality degrades if the
+  // primitives move far; rebuild from time to time.
+  void Refit(const AABB* boxes);
+
+  // Primitives inside or crossing the frustum.
+  void QueryFrustum(const Frustum& frustum, std::vector<u32>& out) const;
+
+  // Primitives whose boxes overlap the sphere.
+  void QuerySphere(const Vector3f& center, float radius,
+                   std::vector<u32>& out) const;
+
+  // Primitives whose boxes are hit by origin + t * dir, 0 <= t <= t_max.
+  void QueryRay(const Vector3f& origin, const Vector3f& dir, float t_max,
+                std::vector<u32>& out) const;
+
+  size_t node_count() const { return nodes_.size(); }
+  size_t primitive_count() const { return prims_.size(); }
+
+ private:
+  // 32 bytes. Interior nodes have count == 0 and their children at
+  // |index| and |index| + 1; leaves hold primitives
+  // [index, index + count) of prims_.
+  struct Node {
+    Vector3f min;
+    u32 index;
+    Vector3f max;
+    u32 count;
+
+    bool IsLeaf() const { return count != 0; }
+  };
+
+  struct BuildContext;
+
+  void BuildNode(BuildContext& ctx, u32 node_index, u32 first, u32 count,
+                 int depth);
+  // Turns |node| into an interior node whose children split its
+  // primitives after the first |left_count|, and builds them.
+  void SplitChildren(BuildContext& ctx, Node& node, u32 first,
+                     u32 left_count, u32 count, int depth);
+
+  // Appends every primitive below |node_index|.
+  void AppendSubtree(u32 node_index, std::vector<u32>& out) const;
+
+  AlignedVector<Node> nodes_;
+  // Primitive indices in leaf order, and their boxes in the same order.
+  std::vector<u32> prims_;
+  std::vector<AABB> prim_boxes_;
+};
+
+#endif  // OGLDEV_BVH_H
@@ -0,0 +1,95 @@
+#include "ogldev_camera.h"
+
+Camera::Camera()
+    : position_(0.0f, 0.0f, 0.0f),
+      u_(1.0f, 0.0f, 0.0f),
+      v_(0.0f, 1.0f, 0.0f),
+      n_(0.0f, 0.0f, 1.0f),
+      view_version_(1),
+      proj_version_(1) {
+  PersProjInfo info = { 60.0f, 16.0f, 9.0f, 0.1f, 1000.0f };
+  proj_.InitPersProjTransform(info);
+}
+
+void Camera::SetPosition(const Vector3f& position) {
+  position_ = position;
+  view_version_++;
+}
+
+void Camera::SetOrientation(const Vector3f& target, const Vector3f& up) {
+  // Same basis as Matrix4f::InitCameraTransform, built once here rather
+  // than on every view matrix.
+  n_ = target;
+  n_.Normalize();
+  u_ = up.Cross(n_);
+  u_.Normalize();
+  v_ = n_.Cross(u_);
+  view_version_++;
+}
+
+void Camera::SetPerspective(const PersProjInfo& info) {
+  proj_.InitPersProjTransform(info);
+  proj_version_++;
+}
+
+void Camera::SetOrthographic(const OrthoProjInfo& info) {
+  proj_.InitOrthoProjTransform(info);
+  proj_version_++;
+}
+
+const Matrix4f& Camera::view() const {
+  if (view_.version != view_version_) {
+    // Rotation into the camera basis after translating by -position.
+    const Vector3f& p = position_;
+    view_.value = Matrix4f(
+        u_.x, u_.y, u_.z, -(u_.x * p.x + u_.y * p.y + u_.z * p.z),
+        v_.x, v_.y, v_.z, -(v_.x * p.x + v_.y * p.y + v_.z * p.z),
+        n_.x, n_.y, n_.z, -(n_.x * p.x + n_.y * p.y + n_.z * p.z),
+        0.0f, 0.0f, 0.0f, 1.0f);
+    view_.version = view_version_;
+  }
+  return view_.value;
+}
+
+const Matrix4f& Camera::view_proj() const {
+  if (view_proj_.version != view_proj_version()) {
+    view_proj_.value = proj() * view();
+    view_proj_.version = view_proj_version();
+  }
+  return view_proj_.value;
+}
+
+const Matrix4f& Camera::inverse_view() const {
+  if (inverse_view_.version != view_version_) {
+    inverse_view_.value = view();
+    inverse_view_.value.InverseRigid();
+    inverse_view_.version = view_version_;
+  }
+  return inverse_view_.value;
+}
+
+const Matrix4f& Camera::inverse_proj() const {
+  if (inverse_proj_.version != proj_version_) {
+    inverse_proj_.value = proj();
+    inverse_proj_.value.Inverse();
+    inverse_proj_.version = proj_version_;
+  }
+  return inverse_proj_.value;
+}
+
+const Matrix4f& Camera::inverse_view_proj() const {
+  if (inverse_view_proj_.version != view_proj_version()) {
+    // Cheaper and more accurate than inverting view_proj() directly.
+    inverse_view_proj_.value = inverse_view() * inverse_proj();
+    inverse_view_proj_.version = view_proj_version();
+  }
+  return inverse_view_proj_.value;
+}
+
+const Frustum& Camera::frustum() const {
+  if (frustum_.version != view_proj_version()) {
+    frustum_.value.Extract(view_proj());
+    frustum_.version = view_proj_version();
+  }
+  return frustum_.value;
+}
@@ -0,0 +1,79 @@
+#ifndef OGLDEV_CAMERA_H
+#define OGLDEV_CAMERA_H
+
+#include "ogldev_frustum.h"
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Camera that caches its view and projection matrices, their product, the
+// inverses of all three and the view frustum.
+//
+// Setters only bump a version counter. Each cached value remembers the
+// versions it was computed from and is rebuilt on first access after a
+// change, so a frame that does not move the camera computes nothing, and a
+// frame that only moves it does not rebuild the projection. Per-object
+// transforms then need one multiply: view_proj() * world.
+//
+// The getters update the caches and are not thread-safe; call them once on
+// the main thread before handing the results to workers.
+class Camera {
+ public:
+  // At the origin looking down +Z with +Y up, 60 degrees vertical field of
+  // view at 16:9, depth range [0.1, 1000].
+  Camera();
+
+  void SetPosition(const Vector3f& position);
+  // |target| is the viewing direction. Both vectors need not be unit length.
+  void SetOrientation(const Vector3f& target, const Vector3f& up);
+  void SetPerspective(const PersProjInfo& info);
+  void SetOrthographic(const OrthoProjInfo& info);
+
+  const Vector3f& position() const { return position_; }
+  // Unit basis: right, up and forward (target) directions.
+  const Vector3f& right() const { return u_; }
+  const Vector3f& up() const { return v_; }
+  const Vector3f& forward() const { return n_; }
+
+  // Change each time the corresponding matrix changes. The view-projection
+  // version changes whenever either of the other two does, so an object can
+  // keep its MVP and the version it was built from.
+  u64 view_version() const { return view_version_; }
+  u64 proj_version() const { return proj_version_; }
+  u64 view_proj_version() const { return view_version_ + proj_version_; }
+
+  const Matrix4f& view() const;
+  const Matrix4f& proj() const { return proj_; }
+  const Matrix4f& view_proj() const;
+  const Matrix4f& inverse_view() const;
+  const Matrix4f& inverse_proj() const;
+  const Matrix4f& inverse_view_proj() const;
+  const Frustum& frustum() const;
+
+  Matrix4f MVP(const Matrix4f& world) const { return view_proj() * world; }
+
+ private:
+  // One cached value and the version it was computed from.
+  template <typename T>
+  struct Cached {
+    Cached() : version(0) {}
+
+    T value;
+    u64 version;
+  };
+
+  Vector3f position_;
+  Vector3f u_, v_, n_;
+  // Built by the setters, which are rare.
+  Matrix4f proj_;
+  u64 view_version_;
+  u64 proj_version_;
+
+  mutable Cached<Matrix4f> view_;
+  mutable Cached<Matrix4f> view_proj_;
+  mutable Cached<Matrix4f> inverse_view_;
+  mutable Cached<Matrix4f> inverse_proj_;
+  mutable Cached<Matrix4f> inverse_view_proj_;
+  mutable Cached<Frustum> frustum_;
+};
+
+#endif  // OGLDEV_CAMERA_H
@@ -0,0 +1,185 @@
+#include "ogldev_compress.h"
+
+#include <cstring>
+#include <vector>
+
+#include "ogldev_types.h"
+
+// Format limits: a match is at least 4 bytes and at most 65535 bytes back;
+// the last 5 bytes are always literals and no match starts in the last 12.
+static const size_t kMinMatch = 4;
+static const size_t kMaxOffset = 65535;
+static const size_t kLastLiterals = 5;
+static const size_t kMatchLimit = 12;
+
+static const int kHashBits = 16;
+
+static u32 Read32(const char* p) {
+  u32 v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static u32 Hash4(u32 v) {
+  return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Writes |len| - 15 as a run of 255s and a final byte (len >= 15).
+static char* WriteLength(char* out, size_t len) {
+  len -= 15;
+  while (len >= 255) {
+    *out++ = static_cast<char>(255);
+    len -= 255;
+  }
+  *out++ = static_cast<char>(len);
+  return out;
+}
+
+static char* WriteSequence(char* out, const char* literals,
+                           size_t literal_len, size_t offset,
+                           size_t match_len) {
+  char* token = out++;
+  u8 t = 0;
+
+  if (literal_len >= 15) {
+    t = 15 << 4;
+    out = WriteLength(out, literal_len);
+  } else {
+    t = static_cast<u8>(literal_len << 4);
+  }
+  memcpy(out, literals, literal_len);
+  out += literal_len;
+
+  if (match_len > 0) {
+    *out++ = static_cast<char>(offset & 0xff);
+    *out++ = static_cast<char>(offset >> 8);
+    const size_t m = match_len - kMinMatch;
+    if (m >= 15) {
+      t |= 15;
+      out = WriteLength(out, m);
+    } else {
+      t |= static_cast<u8>(m);
+    }
+  }
+
+  *token = static_cast<char>(t);
+  return out;
+}
+
+size_t CompressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+size_t Compress(const char* src, size_t size, char* dst) {
+  char* out = dst;
+  size_t anchor = 0;
+
+  if (size > kMatchLimit) {
+    std::vector<u32> table(size_t(1) << kHashBits, 0);
+    const size_t match_end = size - kLastLiterals;
+    const size_t search_end = size - kMatchLimit;
+
+    // table[] holds position + 1 so that 0 means empty.
+    size_t pos = 0;
+    while (pos < search_end) {
+      const u32 v = Read32(src + pos);
+      const u32 h = Hash4(v);
+      const size_t candidate = table[h];
+      table[h] = static_cast<u32>(pos + 1);
+
+      if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+          Read32(src + candidate - 1) != v) {
+        pos++;
+        continue;
+      }
+
+      size_t ref = candidate - 1;
+      // Extend backwards over pending literals, then forwards.
+      while (pos > anchor && ref > 0 && src[pos - 1] == src[ref - 1]) {
+        pos--;
+        ref--;
+      }
+      size_t len = kMinMatch;
+      while (pos + len < match_end && src[pos + len] == src[ref + len]) {
+        len++;
+      }
+
+      out = WriteSequence(out, src + anchor, pos - anchor, pos - ref, len);
+      pos += len;
+      anchor = pos;
+
+      if (pos - 2 < search_end) {
+        table[Hash4(Read32(src + pos - 2))] = static_cast<u32>(pos - 1);
+      }
+    }
+  }
+
+  out = WriteSequence(out, src + anchor, size - anchor, 0, 0);
+  return static_cast<size_t>(out - dst);
+}
+
+// Adds the extension bytes of a length whose 4-bit field was 15. Returns
+// false on truncated input.
+static bool ReadLength(const u8*& in, const u8* in_end, size_t& len) {
+  u8 b;
+  do {
+    if (in == in_end) return false;
+    b = *in++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+bool Decompress(const char* src, size_t size, char* dst, size_t out_size) {
+  const u8* in = reinterpret_cast<const u8*>(src);
+  const u8* in_end = in + size;
+  char* out = dst;
+  char* out_end = dst + out_size;
+
+  for (;;) {
+    if (in == in_end) return false;
+    const u8 token = *in++;
+
+    size_t literal_len = token >> 4;
+    if (literal_len == 15 && !ReadLength(in, in_end, literal_len)) {
+      return false;
+    }
+    if (literal_len > static_cast<size_t>(in_end - in) ||
+        literal_len > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+    memcpy(out, in, literal_len);
+    in += literal_len;
+    out += literal_len;
+
+    // The last sequence has no match.
+    if (in == in_end) {
+      return out == out_end;
+    }
+
+    if (in_end - in < 2) return false;
+    const size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    if (offset == 0 || offset > static_cast<size_t>(out - dst)) {
+      return false;
+    }
+
+    size_t match_len = token & 15;
+    if (match_len == 15 && !ReadLength(in, in_end, match_len)) {
+      return false;
+    }
+    match_len += kMinMatch;
+    if (match_len > static_cast<size_t>(out_end - out)) {
+      return false;
+    }
+
+    // Byte by byte: the match may overlap the bytes it produces.
+    const char* ref = out - offset;
+    if (offset >= match_len) {
+      memcpy(out, ref, match_len);
+    } else {
+      for (size_t i = 0; i < match_len; i++) out[i] = ref[i];
+    }
+    out += match_len;
+  }
+}
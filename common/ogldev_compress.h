@@ -0,0 +1,22 @@
+#ifndef OGLDEV_COMPRESS_H
+#define OGLDEV_COMPRESS_H
+
+#include <cstddef>
+
+// Fast LZ77 compression in the LZ4 block format, for asset data that is
+// compressed once offline and decompressed at load time. Decompression
+// runs at memory speed; the ratio is modest (about 2:1 on text).
+
+// Largest possible Compress() output for |size| input bytes.
+size_t CompressBound(size_t size);
+
+// Compresses |src| into |dst|, which must hold CompressBound(size) bytes.
+// Returns the compressed size.
+size_t Compress(const char* src, size_t size, char* dst);
+
+// Decompresses |src| into exactly |out_size| bytes at |dst|. Returns false
+// if |src| is malformed or does not decode to |out_size| bytes; never reads
+// or writes out of bounds.
+bool Decompress(const char* src, size_t size, char* dst, size_t out_size);
+
+#endif  // OGLDEV_COMPRESS_H
@@ -0,0 +1,78 @@
+#include "ogldev_frame_stats.h"
+
+#include "ogldev_util.h"
+
+static const char* const kMetricNames[FrameStats::kMetricCount] = {
+    "frame", "cpu", "swap", "gpu"};
+
+FrameStats::FrameStats(const std::string& name, FILE* out,
+                       u64 report_interval_ms, float hitch_factor)
+    : name_(name), out_(out), report_interval_ns_(report_interval_ms * 1000000),
+      hitch_factor_(hitch_factor), interval_begin_ns_(0), frame_begin_ns_(0),
+      swap_begin_ns_(0) {}
+
+void FrameStats::BeginFrame() {
+  const u64 now = GetTimeNs();
+  if (frame_begin_ns_ != 0) {
+    histograms_[kFrame].Record(now - frame_begin_ns_);
+  }
+  if (interval_begin_ns_ == 0) {
+    interval_begin_ns_ = now;
+  }
+  frame_begin_ns_ = now;
+  swap_begin_ns_ = 0;
+}
+
+void FrameStats::BeginSwap() {
+  swap_begin_ns_ = GetTimeNs();
+  histograms_[kCpu].Record(swap_begin_ns_ - frame_begin_ns_);
+}
+
+void FrameStats::EndFrame() {
+  const u64 now = GetTimeNs();
+  if (swap_begin_ns_ != 0) {
+    histograms_[kSwap].Record(now - swap_begin_ns_);
+  } else {
+    histograms_[kCpu].Record(now - frame_begin_ns_);
+  }
+  if (report_interval_ns_ != 0 &&
+      now - interval_begin_ns_ >= report_interval_ns_) {
+    Report();
+  }
+}
+
+void FrameStats::AddGpuTime(u64 ns) {
+  histograms_[kGpu].Record(ns);
+}
+
+void FrameStats::Report() {
+  const HdrHistogram& frames = histograms_[kFrame];
+  const u64 now = GetTimeNs();
+  if (frames.count() > 0) {
+    const double seconds = (now - interval_begin_ns_) / 1e9;
+    const u64 hitches = frames.CountAbove(
+        static_cast<u64>(frames.Percentile(50) * hitch_factor_));
+    fprintf(out_, "%s: %llu frames in %.2f s, %.1f fps, %llu hitches "
+                  "(> %.1fx p50)\n",
+            name_.c_str(), static_cast<unsigned long long>(frames.count()),
+            seconds, frames.count() / seconds,
+            static_cast<unsigned long long>(hitches), hitch_factor_);
+    fprintf(out_, "   %-5s %9s %8s %8s %8s %8s\n", "ms", "mean", "p50", "p95",
+            "p99", "max");
+    for (int m = 0; m < kMetricCount; m++) {
+      const HdrHistogram& h = histograms_[m];
+      if (h.count() == 0) {
+        continue;
+      }
+      fprintf(out_, "  %-6s %9.3f %8.3f %8.3f %8.3f %8.3f\n", kMetricNames[m],
+              h.mean() / 1e6, h.Percentile(50) / 1e6, h.Percentile(95) / 1e6,
+              h.Percentile(99) / 1e6, h.max() / 1e6);
+    }
+    fflush(out_);
+  }
+
+  for (HdrHistogram& h : histograms_) {
+    h.Reset();
+  }
+  interval_begin_ns_ = now;
+}
@@ -0,0 +1,82 @@
+#ifndef OGLDEV_FRAME_STATS_H
+#define OGLDEV_FRAME_STATS_H
+
+#include <cstdio>
+#include <string>
+
+#include "ogldev_histogram.h"
+#include "ogldev_types.h"
+
+// Frame timing for a render loop, reported as percentiles so that builds
+// can be compared on their slowest frames rather than on the average:
+//
+//   FrameStats stats("07_rotation");
+//
+//   static void RenderSceneCB() {
+//     stats.BeginFrame();
+//     ...                    // Draw.
+//     stats.BeginSwap();
+//     glutSwapBuffers();
+//     stats.EndFrame();
+//   }
+//
+// Every report_interval_ms the frames of the interval are written to |out|:
+//
+//   07_rotation: 300 frames in 5.00 s, 60.0 fps, 2 hitches (> 2.0x p50)
+//     ms         mean      p50      p95      p99      max
+//    frame     16.667   16.650   16.900   17.200   33.100
+//    cpu        0.123    0.119    0.150    0.210    1.020
+//    swap      16.530   16.510   16.760   17.000   32.950
+//
+// "frame" is the time between consecutive BeginFrame() calls, what the
+// user sees; "cpu" runs from BeginFrame() to BeginSwap() and "swap" from
+// there to EndFrame(). A "gpu" row is added for times passed to
+// AddGpuTime(). Hitches are frames that took more than hitch_factor times
+// the interval's median.
+class FrameStats {
+ public:
+  enum Metric {
+    kFrame,
+    kCpu,
+    kSwap,
+    kGpu,
+    kMetricCount,
+  };
+
+  // |out| is not closed. A |report_interval_ms| of 0 reports only when
+  // Report() is called.
+  explicit FrameStats(const std::string& name, FILE* out = stdout,
+                      u64 report_interval_ms = 5000,
+                      float hitch_factor = 2.0f);
+
+  void BeginFrame();
+  void BeginSwap();
+  // Also writes the report when the interval is over.
+  void EndFrame();
+
+  // GPU time of a frame, e.g. from a GL_TIME_ELAPSED query. Results that
+  // arrive late are fine: only their distribution is reported.
+  void AddGpuTime(u64 ns);
+
+  // Writes the frames since the last report, if any, and starts a new
+  // interval.
+  void Report();
+
+  // The frames since the last report.
+  const HdrHistogram& histogram(Metric metric) const {
+    return histograms_[metric];
+  }
+
+ private:
+  std::string name_;
+  FILE* out_;
+  u64 report_interval_ns_;
+  float hitch_factor_;
+
+  HdrHistogram histograms_[kMetricCount];
+  u64 interval_begin_ns_;  // 0 until the first frame.
+  u64 frame_begin_ns_;
+  u64 swap_begin_ns_;  // 0 when BeginSwap() was not called this frame.
+};
+
+#endif  // OGLDEV_FRAME_STATS_H
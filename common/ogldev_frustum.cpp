@@ -0,0 +1,179 @@
+#include "ogldev_frustum.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "ogldev_simd.h"
+
+void Frustum::Extract(const Matrix4f& view_proj) {
+  const float (*m)[4] = view_proj.m;
+
+  // clip = M * p, a point is inside if -w <= x, y, z <= w, i.e.
+  // row3 + rowK >= 0 and row3 - rowK >= 0.
+  for (int k = 0; k < 3; k++) {
+    for (int side = 0; side < 2; side++) {
+      const float s = side == 0 ? 1.0f : -1.0f;
+      Plane& p = planes_[2 * k + side];
+      p.n = Vector3f(m[3][0] + s * m[k][0], m[3][1] + s * m[k][1],
+                     m[3][2] + s * m[k][2]);
+      p.d = m[3][3] + s * m[k][3];
+
+      const float inv_len =
+          1.0f / sqrtf(p.n.x * p.n.x + p.n.y * p.n.y + p.n.z * p.n.z);
+      p.n *= inv_len;
+      p.d *= inv_len;
+    }
+  }
+}
+
+bool Frustum::ContainsPoint(const Vector3f& p) const {
+  for (int i = 0; i < kPlaneCount; i++) {
+    if (planes_[i].Distance(p) < 0.0f) return false;
+  }
+  return true;
+}
+
+bool Frustum::IntersectsSphere(const Vector3f& center, float radius) const {
+  for (int i = 0; i < kPlaneCount; i++) {
+    if (planes_[i].Distance(center) < -radius) return false;
+  }
+  return true;
+}
+
+bool Frustum::IntersectsAABB(const Vector3f& min, const Vector3f& max) const {
+  for (int i = 0; i < kPlaneCount; i++) {
+    // The corner furthest along the plane normal.
+    const Plane& p = planes_[i];
+    const Vector3f corner(p.n.x >= 0.0f ? max.x : min.x,
+                          p.n.y >= 0.0f ? max.y : min.y,
+                          p.n.z >= 0.0f ? max.z : min.z);
+    if (p.Distance(corner) < 0.0f) return false;
+  }
+  return true;
+}
+
+// Appends base + i for every set bit i of |bits|, without branches. The
+// stores stay within |visible| since n <= base + i at each step.
+static size_t AppendVisible(int bits, u32 base, u32* visible, size_t n) {
+  visible[n] = base + 0;
+  n += bits & 1;
+  visible[n] = base + 1;
+  n += (bits >> 1) & 1;
+  visible[n] = base + 2;
+  n += (bits >> 2) & 1;
+  visible[n] = base + 3;
+  n += (bits >> 3) & 1;
+  return n;
+}
+
+namespace {
+
+// Plane coefficients splatted into all lanes.
+struct SplatPlane {
+  simd::Float4 a, b, c, d;
+
+  void Set(const Plane& p) {
+    a = simd::Splat4(p.n.x);
+    b = simd::Splat4(p.n.y);
+    c = simd::Splat4(p.n.z);
+    d = simd::Splat4(p.d);
+  }
+
+  simd::Float4 Distance(simd::Float4 x, simd::Float4 y,
+                        simd::Float4 z) const {
+    simd::Float4 r = simd::Mul4(a, x);
+    r = simd::Add4(r, simd::Mul4(b, y));
+    r = simd::Add4(r, simd::Mul4(c, z));
+    return simd::Add4(r, d);
+  }
+};
+
+}  // namespace
+
+size_t CullSpheres(const Frustum& frustum, const Vector3fSoA& centers,
+                   const float* radii, u32* visible) {
+  SplatPlane planes[Frustum::kPlaneCount];
+  for (int i = 0; i < Frustum::kPlaneCount; i++) {
+    planes[i].Set(frustum.plane(i));
+  }
+
+  const size_t count = centers.size();
+  const simd::Float4 zero = simd::Splat4(0.0f);
+  size_t n = 0;
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const simd::Float4 x = simd::Load4A(centers.x() + i);
+    const simd::Float4 y = simd::Load4A(centers.y() + i);
+    const simd::Float4 z = simd::Load4A(centers.z() + i);
+    const simd::Float4 neg_r = simd::Sub4(zero, simd::Load4(radii + i));
+
+    simd::Mask4 inside = simd::MaskTrue4();
+    for (int k = 0; k < Frustum::kPlaneCount; k++) {
+      inside = simd::MaskAnd4(
+          inside, simd::CmpGe4(planes[k].Distance(x, y, z), neg_r));
+    }
+
+    n = AppendVisible(simd::MoveMask4(inside), static_cast<u32>(i), visible,
+                      n);
+  }
+
+  for (; i < count; i++) {
+    if (frustum.IntersectsSphere(centers.Get(i), radii[i])) {
+      visible[n++] = static_cast<u32>(i);
+    }
+  }
+
+  return n;
+}
+
+size_t CullAABBs(const Frustum& frustum, const Vector3fSoA& mins,
+                 const Vector3fSoA& maxs, u32* visible) {
+  assert(mins.size() == maxs.size());
+
+  // For each plane, whether the furthest corner along its normal takes the
+  // max (true) or min (false) coordinate on each axis.
+  SplatPlane planes[Frustum::kPlaneCount];
+  bool use_max[Frustum::kPlaneCount][3];
+  for (int k = 0; k < Frustum::kPlaneCount; k++) {
+    const Plane& p = frustum.plane(k);
+    planes[k].Set(p);
+    use_max[k][0] = p.n.x >= 0.0f;
+    use_max[k][1] = p.n.y >= 0.0f;
+    use_max[k][2] = p.n.z >= 0.0f;
+  }
+
+  const size_t count = mins.size();
+  const simd::Float4 zero = simd::Splat4(0.0f);
+  size_t n = 0;
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const simd::Float4 lo[3] = {simd::Load4A(mins.x() + i),
+                                simd::Load4A(mins.y() + i),
+                                simd::Load4A(mins.z() + i)};
+    const simd::Float4 hi[3] = {simd::Load4A(maxs.x() + i),
+                                simd::Load4A(maxs.y() + i),
+                                simd::Load4A(maxs.z() + i)};
+
+    simd::Mask4 inside = simd::MaskTrue4();
+    for (int k = 0; k < Frustum::kPlaneCount; k++) {
+      const simd::Float4 px = use_max[k][0] ? hi[0] : lo[0];
+      const simd::Float4 py = use_max[k][1] ? hi[1] : lo[1];
+      const simd::Float4 pz = use_max[k][2] ? hi[2] : lo[2];
+      inside = simd::MaskAnd4(
+          inside, simd::CmpGe4(planes[k].Distance(px, py, pz), zero));
+    }
+
+    n = AppendVisible(simd::MoveMask4(inside), static_cast<u32>(i), visible,
+                      n);
+  }
+
+  for (; i < count; i++) {
+    if (frustum.IntersectsAABB(mins.Get(i), maxs.Get(i))) {
+      visible[n++] = static_cast<u32>(i);
+    }
+  }
+
+  return n;
+}
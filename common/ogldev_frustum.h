@@ -0,0 +1,57 @@
+#ifndef OGLDEV_FRUSTUM_H
+#define OGLDEV_FRUSTUM_H
+
+#include <cstddef>
+
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+#include "ogldev_vector_soa.h"
+
+// Plane n . p + d = 0, with n pointing into the frustum.
+struct Plane {
+  Vector3f n;
+  float d;
+
+  float Distance(const Vector3f& p) const {
+    return n.x * p.x + n.y * p.y + n.z * p.z + d;
+  }
+};
+
+// View frustum as six inward-facing planes, extracted from a combined
+// projection * view matrix as built with InitPersProjTransform or
+// InitOrthoProjTransform (OpenGL clip space, -w <= x, y, z <= w).
+class Frustum {
+ public:
+  enum PlaneIndex { kLeft, kRight, kBottom, kTop, kNear, kFar, kPlaneCount };
+
+  Frustum() {}
+  explicit Frustum(const Matrix4f& view_proj) { Extract(view_proj); }
+
+  // Gribb-Hartmann extraction; the planes are normalized so distances are
+  // in world units.
+  void Extract(const Matrix4f& view_proj);
+
+  const Plane& plane(int i) const { return planes_[i]; }
+
+  bool ContainsPoint(const Vector3f& p) const;
+  bool IntersectsSphere(const Vector3f& center, float radius) const;
+  bool IntersectsAABB(const Vector3f& min, const Vector3f& max) const;
+
+ private:
+  Plane planes_[kPlaneCount];
+};
+
+// Batch culling. Bounding volumes are given in SoA form and the indices of
+// the visible ones are written to |visible| in increasing order; the return
+// value is their number. |visible| must hold one entry per volume. The
+// tests are conservative: volumes crossing a plane count as visible.
+
+// Spheres with centers[i] and radii[i].
+size_t CullSpheres(const Frustum& frustum, const Vector3fSoA& centers,
+                   const float* radii, u32* visible);
+
+// Axis-aligned boxes [mins[i], maxs[i]].
+size_t CullAABBs(const Frustum& frustum, const Vector3fSoA& mins,
+                 const Vector3fSoA& maxs, u32* visible);
+
+#endif  // OGLDEV_FRUSTUM_H
@@ -0,0 +1,111 @@
+#include "ogldev_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Values below kLinear get a bucket each. Above it, the power of two
+// [2^e, 2^(e+1)) is split into kSubBuckets buckets of width
+// 2^(e - kSubBucketBits).
+static const u64 kLinear = 2 * HdrHistogram::kSubBuckets;
+static const size_t kBucketCount =
+    kLinear + (HdrHistogram::kMaxValueBits - HdrHistogram::kSubBucketBits -
+               1) * HdrHistogram::kSubBuckets;
+
+// Index of the highest set bit of |v|, which must not be 0.
+static u32 HighestBit(u64 v) {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanReverse64(&index, v);
+  return index;
+#else
+  u32 bit = 0;
+  while (v >>= 1) bit++;
+  return bit;
+#endif
+}
+
+static size_t BucketIndex(u64 value) {
+  value = std::min(value, HdrHistogram::kMaxValue - 1);
+  if (value < kLinear) {
+    return static_cast<size_t>(value);
+  }
+  const u32 shift = HighestBit(value) - HdrHistogram::kSubBucketBits;
+  return static_cast<size_t>(kLinear + (shift - 1) * HdrHistogram::kSubBuckets +
+                             (value >> shift) - HdrHistogram::kSubBuckets);
+}
+
+// The largest value that falls into bucket |index|.
+static u64 BucketHighest(size_t index) {
+  if (index < kLinear) {
+    return index;
+  }
+  const u64 j = index - kLinear;
+  const u64 shift = j / HdrHistogram::kSubBuckets + 1;
+  const u64 top = HdrHistogram::kSubBuckets + j % HdrHistogram::kSubBuckets;
+  return ((top + 1) << shift) - 1;
+}
+
+HdrHistogram::HdrHistogram() : counts_(kBucketCount) {
+  Reset();
+}
+
+void HdrHistogram::Record(u64 value) {
+  counts_[BucketIndex(value)]++;
+  count_++;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += value;
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other) {
+  for (size_t i = 0; i < kBucketCount; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+}
+
+void HdrHistogram::Reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = ~0ull;
+  max_ = 0;
+  sum_ = 0;
+}
+
+double HdrHistogram::mean() const {
+  return count_ ? static_cast<double>(sum_) / count_ : 0.0;
+}
+
+u64 HdrHistogram::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const double p = std::min(std::max(percentile, 0.0), 100.0);
+  const u64 rank = std::max<u64>(
+      1, static_cast<u64>(std::ceil(p / 100.0 * count_)));
+  u64 seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(BucketHighest(i), max_);
+    }
+  }
+  return max_;
+}
+
+u64 HdrHistogram::CountAbove(u64 value) const {
+  u64 n = 0;
+  for (size_t i = BucketIndex(value) + 1; i < kBucketCount; i++) {
+    n += counts_[i];
+  }
+  return n;
+}
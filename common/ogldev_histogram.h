@@ -0,0 +1,54 @@
+#ifndef OGLDEV_HISTOGRAM_H
+#define OGLDEV_HISTOGRAM_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_types.h"
+
+// A log-linear histogram of non-negative integers in the style of
+// HdrHistogram: each power of two is split into kSubBuckets equal buckets,
+// so every recorded value is known to within 1/kSubBuckets (0.8%) of
+// itself, whatever its magnitude. Recording is one bucket increment;
+// percentiles walk the buckets. Count, min, max and mean are exact.
+//
+// Values of kMaxValue and above (about 18 minutes in nanoseconds) share
+// the last bucket.
+class HdrHistogram {
+ public:
+  static const u32 kSubBucketBits = 7;
+  static const u64 kSubBuckets = 1ull << kSubBucketBits;
+  static const u32 kMaxValueBits = 40;
+  static const u64 kMaxValue = 1ull << kMaxValueBits;
+
+  HdrHistogram();
+
+  void Record(u64 value);
+  // Adds the values recorded in |other|.
+  void Merge(const HdrHistogram& other);
+  void Reset();
+
+  u64 count() const { return count_; }
+  // 0 when nothing was recorded, as are the functions below.
+  u64 min() const { return count_ ? min_ : 0; }
+  u64 max() const { return max_; }
+  double mean() const;
+
+  // The value that |percentile| percent of the recorded values are at or
+  // below, e.g. Percentile(99) for p99. Rounded up to the largest value of
+  // its bucket, but never above max().
+  u64 Percentile(double percentile) const;
+
+  // Number of recorded values above |value|, counting whole buckets: off
+  // by at most the values in the bucket of |value|.
+  u64 CountAbove(u64 value) const;
+
+ private:
+  std::vector<u32> counts_;
+  u64 count_;
+  u64 min_;
+  u64 max_;
+  u64 sum_;
+};
+
+#endif  // OGLDEV_HISTOGRAM_H
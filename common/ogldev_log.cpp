@@ -0,0 +1,455 @@
+#include "ogldev_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifdef WIN32
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+#include "ogldev_aligned.h"
+
+// Ring capacity in records, a power of two. About 1MB.
+static const size_t kSlotCount = 4096;
+// The logging thread sleeps at most this long when idle, which bounds the
+// latency of a wakeup lost to the lock-free notification below.
+static const std::chrono::milliseconds kIdleWait(10);
+
+std::atomic<u8> g_ogldev_log_level(kLogInfo);
+
+void LogRecord::AddString(const char* s, size_t length) {
+  if (size > kArgBytes - 3) {
+    truncated = true;
+    return;
+  }
+  const size_t room = kArgBytes - size - 3;
+  if (length > room) {
+    length = room;
+    truncated = true;
+  }
+  const u16 n = static_cast<u16>(length);
+  args[size] = static_cast<char>(kArgString);
+  memcpy(args + size + 1, &n, 2);
+  memcpy(args + size + 3, s, length);
+  size = static_cast<u16>(size + 3 + length);
+}
+
+namespace {
+
+// Reads back the values written by LogRecord::Add*().
+class LogArgReader {
+ public:
+  explicit LogArgReader(const LogRecord& r) : r_(r), pos_(0) {}
+
+  struct Arg {
+    LogRecord::ArgType type;
+    size_t width;  // Size of the original argument, 8 for strings.
+    u64 bits;
+    const char* str;
+    size_t length;
+
+    i64 AsInt() const {
+      if (type == LogRecord::kArgDouble) return static_cast<i64>(AsDouble());
+      return static_cast<i64>(bits);
+    }
+    double AsDouble() const {
+      if (type == LogRecord::kArgInt) {
+        return static_cast<double>(static_cast<i64>(bits));
+      }
+      if (type == LogRecord::kArgUint) return static_cast<double>(bits);
+      double d;
+      memcpy(&d, &bits, 8);
+      return d;
+    }
+  };
+
+  bool Next(Arg* arg) {
+    if (pos_ >= r_.size) return false;
+    const u8 tag = static_cast<u8>(r_.args[pos_]);
+    arg->type = static_cast<LogRecord::ArgType>(tag & 0x0f);
+    arg->width = tag >> 4 ? tag >> 4 : 8;
+    if (arg->type == LogRecord::kArgString) {
+      u16 n;
+      memcpy(&n, r_.args + pos_ + 1, 2);
+      arg->str = r_.args + pos_ + 3;
+      arg->length = n;
+      arg->bits = 0;
+      pos_ += 3 + n;
+    } else {
+      memcpy(&arg->bits, r_.args + pos_ + 1, 8);
+      arg->str = nullptr;
+      arg->length = 0;
+      pos_ += 9;
+    }
+    return true;
+  }
+
+ private:
+  const LogRecord& r_;
+  size_t pos_;
+};
+
+// The low |width| bytes of |bits|, zero- or sign-extended.
+u64 ZeroExtend(u64 bits, size_t width) {
+  return width >= 8 ? bits : bits & ((1ull << (8 * width)) - 1);
+}
+
+i64 SignExtend(u64 bits, size_t width) {
+  const unsigned shift = width >= 8 ? 0 : static_cast<unsigned>(64 - 8 * width);
+  return static_cast<i64>(bits << shift) >> shift;
+}
+
+// Bytes an integer conversion reads for the length modifier |length|, or
+// 0 for none.
+size_t LengthModifierWidth(const std::string& length) {
+  if (length == "hh") return 1;
+  if (length == "h") return 2;
+  if (length == "l") return sizeof(long);
+  if (length == "ll" || length == "q" || length == "j") return 8;
+  if (length == "z") return sizeof(size_t);
+  if (length == "t") return sizeof(ptrdiff_t);
+  return 0;
+}
+
+// printf for a captured record: each conversion is formatted on its own
+// with the length modifier replaced by the one matching the stored type.
+// Integers are first cut to the width printf would read: the length
+// modifier's if there is one, otherwise the argument's own, at least an
+// int's as after the default argument promotions.
+void FormatRecord(const LogRecord& r, std::string& out) {
+  LogArgReader reader(r);
+  LogArgReader::Arg arg;
+  char buf[512];
+  const char* f = r.format;
+  while (*f) {
+    if (*f != '%') {
+      const char* next = strchr(f, '%');
+      const size_t n = next ? static_cast<size_t>(next - f) : strlen(f);
+      out.append(f, n);
+      f += n;
+      continue;
+    }
+    if (f[1] == '%') {
+      out += '%';
+      f += 2;
+      continue;
+    }
+
+    std::string spec = "%";
+    f++;
+    while (*f && strchr("-+ #0", *f)) spec += *f++;
+    for (int part = 0; part < 2; part++) {
+      // Width, then precision; '*' takes an int argument.
+      if (part == 1) {
+        if (*f != '.') break;
+        spec += *f++;
+      }
+      if (*f == '*') {
+        f++;
+        spec += std::to_string(reader.Next(&arg) ? arg.AsInt() : 0);
+      } else {
+        while (*f >= '0' && *f <= '9') spec += *f++;
+      }
+    }
+    std::string length;
+    while (*f && strchr("hlLqjzt", *f)) length += *f++;
+    const char conversion = *f;
+    if (!conversion) break;
+    f++;
+
+    if (!reader.Next(&arg)) {
+      out += "<missing>";
+      continue;
+    }
+    size_t width = LengthModifierWidth(length);
+    if (width == 0) {
+      width = arg.type == LogRecord::kArgDouble
+                  ? 8
+                  : std::max(arg.width, sizeof(int));
+    }
+    const u64 int_bits = static_cast<u64>(arg.AsInt());
+    int n = 0;
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        n = snprintf(buf, sizeof(buf), (spec + "lld").c_str(),
+                     static_cast<long long>(SignExtend(int_bits, width)));
+        break;
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+        n = snprintf(buf, sizeof(buf), (spec + "ll" + conversion).c_str(),
+                     static_cast<unsigned long long>(
+                         ZeroExtend(int_bits, width)));
+        break;
+      case 'c':
+        n = snprintf(buf, sizeof(buf), (spec + 'c').c_str(),
+                     static_cast<int>(arg.AsInt()));
+        break;
+      case 'p':
+        n = snprintf(buf, sizeof(buf), (spec + 'p').c_str(),
+                     reinterpret_cast<void*>(static_cast<uintptr_t>(
+                         arg.bits)));
+        break;
+      case 's':
+        if (arg.type == LogRecord::kArgString) {
+          if (spec == "%") {
+            out.append(arg.str, arg.length);
+          } else {
+            const std::string s(arg.str, arg.length);
+            n = snprintf(buf, sizeof(buf), (spec + 's').c_str(), s.c_str());
+          }
+        } else {
+          out += "<not a string>";
+        }
+        break;
+      case 'f': case 'F': case 'e': case 'E':
+      case 'g': case 'G': case 'a': case 'A':
+        n = snprintf(buf, sizeof(buf), (spec + conversion).c_str(),
+                     arg.AsDouble());
+        break;
+      default:
+        out += spec;
+        out += conversion;
+        break;
+    }
+    if (n > 0) out.append(buf, std::min<size_t>(n, sizeof(buf) - 1));
+  }
+  if (r.truncated) {
+    const bool newline = !out.empty() && out.back() == '\n';
+    out.insert(out.size() - newline, " <truncated>");
+  }
+}
+
+struct LogSlot {
+  std::atomic<u64> sequence;
+  LogRecord record;
+};
+
+// Bounded multi-producer, single-consumer ring (after Dmitry Vyukov's
+// bounded MPMC queue). Each slot's sequence says whose turn it is: equal
+// to the write position when free, one more once written, and advanced by
+// the capacity when read.
+class Logger {
+ public:
+  static Logger& Get() {
+    // Never destroyed, so that logging from static destructors stays safe.
+    // The exit handler below drains the ring and stops the thread.
+    static Logger* logger = new Logger();
+    return *logger;
+  }
+
+  void Submit(const LogRecord& record);
+  void Flush();
+  void SetFile(FILE* f) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    file_ = f;
+  }
+
+ private:
+  Logger();
+
+  static void StopAtExit();
+  void Run();
+  // Pops every readable record, formats it into |text| and returns the
+  // number popped.
+  size_t Drain(std::string& text);
+  void Write(const std::string& text);
+
+  LogSlot* slots_;
+  // Producers and the consumer each get their own cache line.
+  char pad0_[kCacheLineSize];
+  std::atomic<u64> write_pos_;
+  char pad1_[kCacheLineSize];
+  u64 read_pos_;
+  std::atomic<u64> written_pos_;
+  std::atomic<u64> dropped_;
+
+  std::atomic<bool> sleeping_;
+  // Set at exit: stopping_ tells the thread to finish, stopped_ that it
+  // has and records are now written by the caller.
+  std::atomic<bool> stopping_;
+  std::atomic<bool> stopped_;
+  std::mutex wait_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable flushed_;
+
+  // Serializes output between the logging thread and the synchronous path
+  // used after exit.
+  std::mutex write_mutex_;
+  FILE* file_;
+  std::thread thread_;
+};
+
+Logger::Logger()
+    : write_pos_(0), read_pos_(0), written_pos_(0), dropped_(0),
+      sleeping_(false), stopping_(false), stopped_(false), file_(stderr) {
+  slots_ = static_cast<LogSlot*>(
+      AlignedMalloc(kSlotCount * sizeof(LogSlot), kCacheLineSize));
+  if (!slots_) {
+    throw std::bad_alloc();
+  }
+  for (size_t i = 0; i < kSlotCount; i++) {
+    new (&slots_[i].sequence) std::atomic<u64>(i);
+  }
+  thread_ = std::thread(&Logger::Run, this);
+  atexit(StopAtExit);
+}
+
+void Logger::StopAtExit() {
+  Logger& logger = Get();
+  logger.stopping_ = true;
+  logger.wake_.notify_one();
+  logger.thread_.join();
+  logger.stopped_ = true;
+
+  // Records committed after the thread's last pass.
+  std::string text;
+  logger.Drain(text);
+  if (!text.empty()) {
+    logger.Write(text);
+  }
+}
+
+void Logger::Submit(const LogRecord& record) {
+  if (stopped_.load(std::memory_order_acquire)) {
+    // After exit: no thread left to hand the record to.
+    std::string text;
+    FormatRecord(record, text);
+    Write(text);
+    return;
+  }
+
+  u64 pos = write_pos_.load(std::memory_order_relaxed);
+  LogSlot* slot;
+  for (;;) {
+    slot = &slots_[pos & (kSlotCount - 1)];
+    const u64 seq = slot->sequence.load(std::memory_order_acquire);
+    const i64 diff = static_cast<i64>(seq - pos);
+    if (diff == 0) {
+      if (write_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Full: the slot still holds a record from one lap ago.
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = write_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  memcpy(static_cast<void*>(&slot->record), &record, record.used_bytes());
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  if (sleeping_.load(std::memory_order_seq_cst)) {
+    wake_.notify_one();
+  }
+}
+
+size_t Logger::Drain(std::string& text) {
+  size_t count = 0;
+  for (;;) {
+    LogSlot& slot = slots_[read_pos_ & (kSlotCount - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != read_pos_ + 1) {
+      break;
+    }
+    const LogRecord& r = slot.record;
+    text += r.file;
+    text += ':';
+    text += std::to_string(r.line);
+    static const char* const kLevelNames[] = {"debug: ", "info: ",
+                                              "warning: ", ""};
+    text += " - ";
+    text += kLevelNames[std::min<int>(r.level, kLogError)];
+    FormatRecord(r, text);
+    if (text.empty() || text.back() != '\n') text += '\n';
+
+    slot.sequence.store(read_pos_ + kSlotCount, std::memory_order_release);
+    read_pos_++;
+    count++;
+  }
+
+  const u64 dropped = dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped) {
+    text += std::to_string(dropped) + " log messages dropped\n";
+  }
+  return count;
+}
+
+void Logger::Write(const std::string& text) {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  fwrite(text.data(), 1, text.size(), file_);
+  fflush(file_);
+#ifdef WIN32
+  OutputDebugStringA(text.c_str());
+#endif
+}
+
+void Logger::Run() {
+  std::string text;
+  for (;;) {
+    text.clear();
+    const size_t count = Drain(text);
+    if (!text.empty()) {
+      Write(text);
+    }
+    if (count) {
+      written_pos_.store(read_pos_, std::memory_order_release);
+      std::lock_guard<std::mutex> lock(wait_mutex_);
+      flushed_.notify_all();
+      continue;
+    }
+
+    if (stopping_) {
+      return;
+    }
+
+    // Producers notify without the mutex, so a wakeup can be lost between
+    // the check and the wait; the timeout bounds the delay.
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    sleeping_.store(true, std::memory_order_seq_cst);
+    const LogSlot& next = slots_[read_pos_ & (kSlotCount - 1)];
+    if (next.sequence.load(std::memory_order_acquire) != read_pos_ + 1 &&
+        !stopping_) {
+      wake_.wait_for(lock, kIdleWait);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void Logger::Flush() {
+  const u64 target = write_pos_.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(wait_mutex_);
+  wake_.notify_one();
+  while (written_pos_.load(std::memory_order_acquire) < target &&
+         !stopped_) {
+    flushed_.wait_for(lock, kIdleWait);
+  }
+}
+
+}  // namespace
+
+void SetLogLevel(LogLevel level) {
+  g_ogldev_log_level.store(level, std::memory_order_relaxed);
+}
+
+void SetLogFile(FILE* f) {
+  Logger::Get().SetFile(f);
+}
+
+void FlushLog() {
+  Logger::Get().Flush();
+}
+
+void SubmitLogRecord(const LogRecord& record) {
+  Logger::Get().Submit(record);
+}
@@ -0,0 +1,176 @@
+#ifndef OGLDEV_LOG_H
+#define OGLDEV_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "ogldev_types.h"
+
+// Asynchronous logging behind OGLDEV_ERROR and friends (ogldev_util.h).
+//
+// A log call does not format anything. It copies the format string
+// pointer and its arguments in binary form into a LogRecord, strings
+// included, and pushes the record into a lock-free ring buffer shared by
+// all threads. A background thread formats the records printf-style and
+// writes them out in batches. The calling thread pays for the level check,
+// the copy and one atomic increment. It never waits: if the ring is full
+// the message is dropped and counted, and the count is logged later.
+//
+// Format strings must outlive the logging thread, which string literals
+// do; the OGLDEV_* macros only accept literals. Pending messages are
+// written at exit and by FlushLog().
+
+enum LogLevel : u8 {
+  kLogDebug,
+  kLogInfo,
+  kLogWarning,
+  kLogError,
+  kLogNone,  // For SetLogLevel(): nothing is logged.
+};
+
+// Messages below |level| are discarded in the calling thread before their
+// arguments are captured. Defaults to kLogInfo.
+void SetLogLevel(LogLevel level);
+
+// Where the logging thread writes, stderr by default. On Windows messages
+// also go to the debugger output.
+void SetLogFile(FILE* f);
+
+// Blocks until every message logged before the call has been written.
+void FlushLog();
+
+extern std::atomic<u8> g_ogldev_log_level;
+
+inline bool LogEnabled(LogLevel level) {
+  return level >= g_ogldev_log_level.load(std::memory_order_relaxed);
+}
+
+// One log call with its arguments, as tagged binary values in |args|. A tag
+// byte holds the ArgType in its low four bits and, for scalars, the size
+// in bytes of the original argument in its high four, so that e.g. an int
+// -1 prints as ffffffff under %x like it does with printf.
+struct LogRecord {
+  enum ArgType : u8 {
+    kArgInt,
+    kArgUint,
+    kArgDouble,
+    kArgPointer,
+    kArgString,  // u16 length, then the bytes.
+  };
+
+  static const size_t kArgBytes = 224;
+
+  LogRecord(LogLevel level_, const char* file_, u32 line_,
+            const char* format_)
+      : file(file_), format(format_), line(line_), level(level_), size(0),
+        truncated(false) {}
+
+  // |width| is sizeof the argument before it was widened to 64 bits.
+  void AddInt(i64 v, size_t width = 8) { AddScalar(kArgInt, width, &v); }
+  void AddUint(u64 v, size_t width = 8) { AddScalar(kArgUint, width, &v); }
+  void AddDouble(double v) { AddScalar(kArgDouble, 8, &v); }
+  void AddPointer(const void* p) {
+    const u64 v = reinterpret_cast<uintptr_t>(p);
+    AddScalar(kArgPointer, 8, &v);
+  }
+  // Keeps as much of the string as fits.
+  void AddString(const char* s, size_t length);
+
+  // Header and used argument bytes; what has to be copied.
+  size_t used_bytes() const { return offsetof(LogRecord, args) + size; }
+
+  const char* file;
+  const char* format;
+  u32 line;
+  LogLevel level;
+  u16 size;
+  bool truncated;  // Arguments did not fit and were cut or left out.
+  char args[kArgBytes];
+
+ private:
+  void AddScalar(ArgType type, size_t width, const void* v) {
+    if (size > kArgBytes - 9) {
+      truncated = true;
+      return;
+    }
+    args[size] = static_cast<char>(type | width << 4);
+    memcpy(args + size + 1, v, 8);
+    size = static_cast<u16>(size + 9);
+  }
+};
+
+// Hands the record to the logging thread.
+void SubmitLogRecord(const LogRecord& record);
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_signed<T>::value>::type
+CaptureLogArg(LogRecord& r, T v) {
+  r.AddInt(v, sizeof(T));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        !std::is_signed<T>::value>::type
+CaptureLogArg(LogRecord& r, T v) {
+  r.AddUint(v, sizeof(T));
+}
+
+template <typename T>
+typename std::enable_if<std::is_enum<T>::value>::type CaptureLogArg(
+    LogRecord& r, T v) {
+  r.AddInt(static_cast<i64>(v), sizeof(T));
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+CaptureLogArg(LogRecord& r, T v) {
+  r.AddDouble(v);
+}
+
+template <typename T>
+typename std::enable_if<
+    std::is_pointer<T>::value &&
+    !std::is_same<typename std::remove_cv<
+                      typename std::remove_pointer<T>::type>::type,
+                  char>::value>::type
+CaptureLogArg(LogRecord& r, T p) {
+  r.AddPointer(p);
+}
+
+inline void CaptureLogArg(LogRecord& r, const char* s) {
+  if (s) {
+    r.AddString(s, strlen(s));
+  } else {
+    r.AddString("(null)", 6);
+  }
+}
+
+inline void CaptureLogArg(LogRecord& r, const std::string& s) {
+  r.AddString(s.data(), s.size());
+}
+
+inline void CaptureLogArgs(LogRecord&) {}
+
+template <typename T, typename... Rest>
+void CaptureLogArgs(LogRecord& r, const T& first, const Rest&... rest) {
+  CaptureLogArg(r, first);
+  CaptureLogArgs(r, rest...);
+}
+
+template <typename... Args>
+void OgldevLog(LogLevel level, const char* file, u32 line, const char* format,
+               const Args&... args) {
+  if (!LogEnabled(level)) {
+    return;
+  }
+  LogRecord record(level, file, line, format);
+  CaptureLogArgs(record, args...);
+  SubmitLogRecord(record);
+}
+
+#endif  // OGLDEV_LOG_H
@@ -0,0 +1,232 @@
+#include "ogldev_mapped_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ogldev_util.h"
+
+const size_t MappedFile::kMinMapSize;
+
+MappedFile::MappedFile()
+    : data_(NULL), size_(0), open_(false), mapped_(false) {}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(NULL), size_(0), open_(false), mapped_(false) {
+  MoveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    Close();
+    MoveFrom(other);
+  }
+  return *this;
+}
+
+void MappedFile::MoveFrom(MappedFile& other) {
+  size_ = other.size_;
+  open_ = other.open_;
+  mapped_ = other.mapped_;
+  buffer_ = std::move(other.buffer_);
+  // A short buffer lives inside the string object, so it moved.
+  data_ = mapped_ || buffer_.empty() ? other.data_ : buffer_.data();
+
+  other.data_ = NULL;
+  other.size_ = 0;
+  other.open_ = false;
+  other.mapped_ = false;
+}
+
+bool MappedFile::Open(const char* fileName, AccessPattern access) {
+  Close();
+
+  if (!Map(fileName, access) && !Read(fileName)) {
+    Close();
+    return false;
+  }
+
+  open_ = true;
+  return true;
+}
+
+bool MappedFile::Read(const char* fileName) {
+  if (!ReadFile(fileName, buffer_)) {
+    return false;
+  }
+
+  data_ = buffer_.empty() ? NULL : buffer_.data();
+  size_ = buffer_.size();
+  return true;
+}
+
+FileSpan MappedFile::span(size_t offset, size_t size) const {
+  offset = std::min(offset, size_);
+  FileSpan s = { data_ + offset, std::min(size, size_ - offset) };
+  return s;
+}
+
+#ifdef WIN32
+
+void MappedFile::Close() {
+  if (mapped_) {
+    UnmapViewOfFile(data_);
+  }
+  std::string().swap(buffer_);
+  data_ = NULL;
+  size_ = 0;
+  open_ = false;
+  mapped_ = false;
+}
+
+// Returns false without an error if the file is small or cannot be mapped,
+// so that Open() falls back to Read().
+bool MappedFile::Map(const char* fileName, AccessPattern access) {
+  const DWORD flags = access == kAccessSequential ? FILE_FLAG_SEQUENTIAL_SCAN
+                      : access == kAccessRandom   ? FILE_FLAG_RANDOM_ACCESS
+                                                  : FILE_ATTRIBUTE_NORMAL;
+  HANDLE f = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, flags, NULL);
+  if (f == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(f, &file_size) ||
+      static_cast<u64>(file_size.QuadPart) < kMinMapSize ||
+      static_cast<u64>(file_size.QuadPart) > SIZE_MAX) {
+    CloseHandle(f);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(f);
+  if (mapping == NULL) {
+    return false;
+  }
+
+  // The view keeps the mapping alive.
+  void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (p == NULL) {
+    return false;
+  }
+
+  data_ = static_cast<const char*>(p);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  mapped_ = true;
+
+  if (access == kAccessWillNeed) {
+    Prefetch(0, size_);
+  }
+  return true;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+#if _WIN32_WINNT >= 0x0602
+  const FileSpan s = span(offset, size);
+  if (!mapped_ || s.empty()) {
+    return;
+  }
+
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<char*>(s.data);
+  range.NumberOfBytes = s.size;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+  (void)offset;
+  (void)size;
+#endif
+}
+
+#else
+
+void MappedFile::Close() {
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  std::string().swap(buffer_);
+  data_ = NULL;
+  size_ = 0;
+  open_ = false;
+  mapped_ = false;
+}
+
+static int ToAdvice(MappedFile::AccessPattern access) {
+  switch (access) {
+    case MappedFile::kAccessSequential:
+      return MADV_SEQUENTIAL;
+    case MappedFile::kAccessRandom:
+      return MADV_RANDOM;
+    case MappedFile::kAccessWillNeed:
+      return MADV_WILLNEED;
+    default:
+      return MADV_NORMAL;
+  }
+}
+
+// Returns false without an error if the file is small or cannot be mapped,
+// so that Open() falls back to Read().
+bool MappedFile::Map(const char* fileName, AccessPattern access) {
+#ifdef O_CLOEXEC
+  int f = open(fileName, O_RDONLY | O_CLOEXEC);
+#else
+  int f = open(fileName, O_RDONLY);
+#endif
+  if (f == -1) {
+    return false;
+  }
+
+  struct stat stat_buf;
+  if (fstat(f, &stat_buf) != 0 || !S_ISREG(stat_buf.st_mode) ||
+      static_cast<u64>(stat_buf.st_size) < kMinMapSize ||
+      static_cast<u64>(stat_buf.st_size) > SIZE_MAX) {
+    close(f);
+    return false;
+  }
+
+  const size_t size = static_cast<size_t>(stat_buf.st_size);
+  void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, f, 0);
+  // The mapping keeps the file alive.
+  close(f);
+  if (p == MAP_FAILED) {
+    return false;
+  }
+
+  if (access != kAccessNormal) {
+    madvise(p, size, ToAdvice(access));
+  }
+
+  data_ = static_cast<const char*>(p);
+  size_ = size;
+  mapped_ = true;
+  return true;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+  const FileSpan s = span(offset, size);
+  if (!mapped_ || s.empty()) {
+    return;
+  }
+
+  // madvise wants a page-aligned start.
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t start = (s.data - data_) / page * page;
+  madvise(const_cast<char*>(data_ + start), s.data + s.size - data_ - start,
+          MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef OGLDEV_MAPPED_FILE_H
+#define OGLDEV_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+#include "ogldev_types.h"
+
+// A read-only range of bytes owned by someone else, e.g. a MappedFile.
+struct FileSpan {
+  const char* data;
+  size_t size;
+
+  bool empty() const { return size == 0; }
+};
+
+// Read-only view of a whole file.
+//
+// Files of kMinMapSize bytes and more are mapped into memory (mmap, or a
+// file mapping on Windows), so opening costs no copy and pages are read on
+// first access. Smaller files, for which the mapping costs more than a
+// copy, and files that cannot be mapped are read into an owned buffer.
+// Either way data() and every span stay valid until Close() or destruction;
+// a move keeps them valid in the new owner.
+//
+//   MappedFile file;
+//   if (file.Open("mesh.bin", MappedFile::kAccessSequential)) {
+//     FileSpan header = file.span(0, sizeof(MeshHeader));
+//     ...
+//   }
+class MappedFile {
+ public:
+  static const size_t kMinMapSize = 64 * 1024;
+
+  // How the mapping will be read, passed on to the OS (madvise on POSIX).
+  enum AccessPattern {
+    kAccessNormal,
+    // Read front to back: aggressive read-ahead, pages dropped early.
+    kAccessSequential,
+    // Scattered reads: no read-ahead.
+    kAccessRandom,
+    // Start reading the whole file in the background now.
+    kAccessWillNeed,
+  };
+
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Closes any previous file. Reports errors with OGLDEV_ERROR and returns
+  // false on failure.
+  bool Open(const char* fileName, AccessPattern access = kAccessNormal);
+  void Close();
+
+  bool is_open() const { return open_; }
+  // True if the contents are mapped rather than copied.
+  bool is_mapped() const { return mapped_; }
+  // Not null-terminated. May be null for an empty file.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Bytes [offset, offset + size), clipped to the end of the file.
+  FileSpan span(size_t offset, size_t size) const;
+  FileSpan span() const { return span(0, size_); }
+
+  // Hints that [offset, offset + size) will be read soon. No-op for a
+  // buffered file.
+  void Prefetch(size_t offset, size_t size) const;
+
+ private:
+  bool Map(const char* fileName, AccessPattern access);
+  bool Read(const char* fileName);
+  void MoveFrom(MappedFile& other);
+
+  const char* data_;
+  size_t size_;
+  bool open_;
+  bool mapped_;
+  std::string buffer_;
+};
+
+#endif  // OGLDEV_MAPPED_FILE_H
@@ -17,10 +17,12 @@
 */
 
 #include <stdlib.h>
+#include <cmath>
 
 
 #include "ogldev_util.h"
 #include "ogldev_math_3d.h"
+#include "ogldev_random.h"
 
 Vector3f Vector3f::Cross(const Vector3f& v) const
 {
@@ -63,38 +65,63 @@ void Vector3f::Rotate(float Angle, const Vector3f& Axe)
 }
 
 
-void Matrix4f::InitScaleTransform(float ScaleX, float ScaleY, float ScaleZ)
+// Writes rz * ry * rx (see InitRotateTransform) into the upper 3x3 of m,
+// with column j scaled by s[j]. Expanding the product by hand saves the two
+// full matrix multiplications and pairs up the sin/cos calls.
+static void InitEulerRotationScale(Matrix4f& m, float RotateX, float RotateY, float RotateZ,
+                                   float ScaleX, float ScaleY, float ScaleZ)
 {
-    m[0][0] = ScaleX; m[0][1] = 0.0f;   m[0][2] = 0.0f;   m[0][3] = 0.0f;
-    m[1][0] = 0.0f;   m[1][1] = ScaleY; m[1][2] = 0.0f;   m[1][3] = 0.0f;
-    m[2][0] = 0.0f;   m[2][1] = 0.0f;   m[2][2] = ScaleZ; m[2][3] = 0.0f;
-    m[3][0] = 0.0f;   m[3][1] = 0.0f;   m[3][2] = 0.0f;   m[3][3] = 1.0f;
+    float sx, cx, sy, cy, sz, cz;
+    SinCos(ToRadian(RotateX), sx, cx);
+    SinCos(ToRadian(RotateY), sy, cy);
+    SinCos(ToRadian(RotateZ), sz, cz);
+
+    m.m[0][0] = (cz * cy) * ScaleX;
+    m.m[0][1] = (-sz * cx - cz * sy * sx) * ScaleY;
+    m.m[0][2] = (sz * sx - cz * sy * cx) * ScaleZ;
+    m.m[1][0] = (sz * cy) * ScaleX;
+    m.m[1][1] = (cz * cx - sz * sy * sx) * ScaleY;
+    m.m[1][2] = (-cz * sx - sz * sy * cx) * ScaleZ;
+    m.m[2][0] = sy * ScaleX;
+    m.m[2][1] = (cy * sx) * ScaleY;
+    m.m[2][2] = (cy * cx) * ScaleZ;
 }
 
 void Matrix4f::InitRotateTransform(float RotateX, float RotateY, float RotateZ)
 {
-    Matrix4f rx, ry, rz;
+    InitEulerRotationScale(*this, RotateX, RotateY, RotateZ, 1.0f, 1.0f, 1.0f);
+
+    m[0][3] = 0.0f;
+    m[1][3] = 0.0f;
+    m[2][3] = 0.0f;
+    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+}
 
-    const float x = ToRadian(RotateX);
-    const float y = ToRadian(RotateY);
-    const float z = ToRadian(RotateZ);
 
-    rx.m[0][0] = 1.0f; rx.m[0][1] = 0.0f   ; rx.m[0][2] = 0.0f    ; rx.m[0][3] = 0.0f;
-    rx.m[1][0] = 0.0f; rx.m[1][1] = cosf(x); rx.m[1][2] = -sinf(x); rx.m[1][3] = 0.0f;
-    rx.m[2][0] = 0.0f; rx.m[2][1] = sinf(x); rx.m[2][2] = cosf(x) ; rx.m[2][3] = 0.0f;
-    rx.m[3][0] = 0.0f; rx.m[3][1] = 0.0f   ; rx.m[3][2] = 0.0f    ; rx.m[3][3] = 1.0f;
+void Matrix4f::InitTRS(const Vector3f& Translation, const Vector3f& Rotation, const Vector3f& Scale)
+{
+    InitEulerRotationScale(*this, Rotation.x, Rotation.y, Rotation.z, Scale.x, Scale.y, Scale.z);
 
-    ry.m[0][0] = cosf(y); ry.m[0][1] = 0.0f; ry.m[0][2] = -sinf(y); ry.m[0][3] = 0.0f;
-    ry.m[1][0] = 0.0f   ; ry.m[1][1] = 1.0f; ry.m[1][2] = 0.0f    ; ry.m[1][3] = 0.0f;
-    ry.m[2][0] = sinf(y); ry.m[2][1] = 0.0f; ry.m[2][2] = cosf(y) ; ry.m[2][3] = 0.0f;
-    ry.m[3][0] = 0.0f   ; ry.m[3][1] = 0.0f; ry.m[3][2] = 0.0f    ; ry.m[3][3] = 1.0f;
+    m[0][3] = Translation.x;
+    m[1][3] = Translation.y;
+    m[2][3] = Translation.z;
+    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+}
 
-    rz.m[0][0] = cosf(z); rz.m[0][1] = -sinf(z); rz.m[0][2] = 0.0f; rz.m[0][3] = 0.0f;
-    rz.m[1][0] = sinf(z); rz.m[1][1] = cosf(z) ; rz.m[1][2] = 0.0f; rz.m[1][3] = 0.0f;
-    rz.m[2][0] = 0.0f   ; rz.m[2][1] = 0.0f    ; rz.m[2][2] = 1.0f; rz.m[2][3] = 0.0f;
-    rz.m[3][0] = 0.0f   ; rz.m[3][1] = 0.0f    ; rz.m[3][2] = 0.0f; rz.m[3][3] = 1.0f;
 
-    *this = rz * ry * rx;
+void Matrix4f::InitTRS(const Vector3f& Translation, const Quaternion& Rotation, const Vector3f& Scale)
+{
+    InitRotateTransform(Rotation);
+
+    for (unsigned int i = 0 ; i < 3 ; i++) {
+        m[i][0] *= Scale.x;
+        m[i][1] *= Scale.y;
+        m[i][2] *= Scale.z;
+    }
+
+    m[0][3] = Translation.x;
+    m[1][3] = Translation.y;
+    m[2][3] = Translation.z;
 }
 
 
@@ -125,15 +152,6 @@ void Matrix4f::InitRotateTransform(const Quaternion& quat)
     m[3][3] = 1.0f;
 }
 
-void Matrix4f::InitTranslationTransform(float x, float y, float z)
-{
-    m[0][0] = 1.0f; m[0][1] = 0.0f; m[0][2] = 0.0f; m[0][3] = x;
-    m[1][0] = 0.0f; m[1][1] = 1.0f; m[1][2] = 0.0f; m[1][3] = y;
-    m[2][0] = 0.0f; m[2][1] = 0.0f; m[2][2] = 1.0f; m[2][3] = z;
-    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
-}
-
-
 void Matrix4f::InitCameraTransform(const Vector3f& Target, const Vector3f& Up)
 {
     Vector3f N = Target;
@@ -162,22 +180,6 @@ void Matrix4f::InitPersProjTransform(const PersProjInfo& p)
 }
 
 
-void Matrix4f::InitOrthoProjTransform(const OrthoProjInfo& p)
-{
-    float l = p.l;
-    float r = p.r;
-    float b = p.b;
-    float t = p.t;
-    float n = p.n;
-    float f = p.f;
-    
-    m[0][0] = 2.0f/(r - l); m[0][1] = 0.0f;         m[0][2] = 0.0f;         m[0][3] = -(r + l)/(r - l);
-    m[1][0] = 0.0f;         m[1][1] = 2.0f/(t - b); m[1][2] = 0.0f;         m[1][3] = -(t + b)/(t - b);
-    m[2][0] = 0.0f;         m[2][1] = 0.0f;         m[2][2] = 2.0f/(f - n); m[2][3] = -(f + n)/(f - n);
-    m[3][0] = 0.0f;         m[3][1] = 0.0f;         m[3][2] = 0.0f;         m[3][3] = 1.0;        
-}
-
-
 float Matrix4f::Determinant() const
 {
 	return m[0][0]*m[1][1]*m[2][2]*m[3][3] - m[0][0]*m[1][1]*m[2][3]*m[3][2] + m[0][0]*m[1][2]*m[2][3]*m[3][1] - m[0][0]*m[1][2]*m[2][1]*m[3][3] 
@@ -189,55 +191,127 @@ float Matrix4f::Determinant() const
 }
 
 
+// Shared-cofactor inverse: the 12 2x2 sub-determinants of the top and
+// bottom row pairs are computed once and reused for the determinant and all
+// 16 cofactors.
+bool Matrix4f::TryInverse(Matrix4f& Result) const
+{
+    const float a0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    const float a1 = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+    const float a2 = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+    const float a3 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    const float a4 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+    const float a5 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+    const float b0 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+    const float b1 = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+    const float b2 = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+    const float b3 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+    const float b4 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+    const float b5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+
+    const float det = a0 * b5 - a1 * b4 + a2 * b3 + a3 * b2 - a4 * b1 + a5 * b0;
+    if (det == 0.0f || !std::isfinite(det)) {
+        return false;
+    }
+
+    const float invdet = 1.0f / det;
+
+    Result.m[0][0] = ( m[1][1] * b5 - m[1][2] * b4 + m[1][3] * b3) * invdet;
+    Result.m[0][1] = (-m[0][1] * b5 + m[0][2] * b4 - m[0][3] * b3) * invdet;
+    Result.m[0][2] = ( m[3][1] * a5 - m[3][2] * a4 + m[3][3] * a3) * invdet;
+    Result.m[0][3] = (-m[2][1] * a5 + m[2][2] * a4 - m[2][3] * a3) * invdet;
+    Result.m[1][0] = (-m[1][0] * b5 + m[1][2] * b2 - m[1][3] * b1) * invdet;
+    Result.m[1][1] = ( m[0][0] * b5 - m[0][2] * b2 + m[0][3] * b1) * invdet;
+    Result.m[1][2] = (-m[3][0] * a5 + m[3][2] * a2 - m[3][3] * a1) * invdet;
+    Result.m[1][3] = ( m[2][0] * a5 - m[2][2] * a2 + m[2][3] * a1) * invdet;
+    Result.m[2][0] = ( m[1][0] * b4 - m[1][1] * b2 + m[1][3] * b0) * invdet;
+    Result.m[2][1] = (-m[0][0] * b4 + m[0][1] * b2 - m[0][3] * b0) * invdet;
+    Result.m[2][2] = ( m[3][0] * a4 - m[3][1] * a2 + m[3][3] * a0) * invdet;
+    Result.m[2][3] = (-m[2][0] * a4 + m[2][1] * a2 - m[2][3] * a0) * invdet;
+    Result.m[3][0] = (-m[1][0] * b3 + m[1][1] * b1 - m[1][2] * b0) * invdet;
+    Result.m[3][1] = ( m[0][0] * b3 - m[0][1] * b1 + m[0][2] * b0) * invdet;
+    Result.m[3][2] = (-m[3][0] * a3 + m[3][1] * a1 - m[3][2] * a0) * invdet;
+    Result.m[3][3] = ( m[2][0] * a3 - m[2][1] * a1 + m[2][2] * a0) * invdet;
+
+    return true;
+}
+
+
 Matrix4f& Matrix4f::Inverse()
 {
-	// Compute the reciprocal determinant
-	float det = Determinant();
-	if(det == 0.0f) 
-	{
-		// Matrix not invertible. Setting all elements to nan is not really
-		// correct in a mathematical sense but it is easy to debug for the
-		// programmer.
-		/*const float nan = std::numeric_limits<float>::quiet_NaN();
-		*this = Matrix4f(
-			nan,nan,nan,nan,
-			nan,nan,nan,nan,
-			nan,nan,nan,nan,
-			nan,nan,nan,nan);*/
+    Matrix4f res;
+    if (!TryInverse(res)) {
+        // Matrix not invertible.
         assert(0);
-		return *this;
-	}
-
-	float invdet = 1.0f / det;
-
-	Matrix4f res;
-	res.m[0][0] = invdet  * (m[1][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[1][2] * (m[2][3] * m[3][1] - m[2][1] * m[3][3]) + m[1][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]));
-	res.m[0][1] = -invdet * (m[0][1] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[0][2] * (m[2][3] * m[3][1] - m[2][1] * m[3][3]) + m[0][3] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]));
-	res.m[0][2] = invdet  * (m[0][1] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) + m[0][2] * (m[1][3] * m[3][1] - m[1][1] * m[3][3]) + m[0][3] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]));
-	res.m[0][3] = -invdet * (m[0][1] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) + m[0][2] * (m[1][3] * m[2][1] - m[1][1] * m[2][3]) + m[0][3] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]));
-	res.m[1][0] = -invdet * (m[1][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[1][2] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) + m[1][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]));
-	res.m[1][1] = invdet  * (m[0][0] * (m[2][2] * m[3][3] - m[2][3] * m[3][2]) + m[0][2] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) + m[0][3] * (m[2][0] * m[3][2] - m[2][2] * m[3][0]));
-	res.m[1][2] = -invdet * (m[0][0] * (m[1][2] * m[3][3] - m[1][3] * m[3][2]) + m[0][2] * (m[1][3] * m[3][0] - m[1][0] * m[3][3]) + m[0][3] * (m[1][0] * m[3][2] - m[1][2] * m[3][0]));
-	res.m[1][3] = invdet  * (m[0][0] * (m[1][2] * m[2][3] - m[1][3] * m[2][2]) + m[0][2] * (m[1][3] * m[2][0] - m[1][0] * m[2][3]) + m[0][3] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]));
-	res.m[2][0] = invdet  * (m[1][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) + m[1][1] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) + m[1][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
-	res.m[2][1] = -invdet * (m[0][0] * (m[2][1] * m[3][3] - m[2][3] * m[3][1]) + m[0][1] * (m[2][3] * m[3][0] - m[2][0] * m[3][3]) + m[0][3] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
-	res.m[2][2] = invdet  * (m[0][0] * (m[1][1] * m[3][3] - m[1][3] * m[3][1]) + m[0][1] * (m[1][3] * m[3][0] - m[1][0] * m[3][3]) + m[0][3] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]));
-	res.m[2][3] = -invdet * (m[0][0] * (m[1][1] * m[2][3] - m[1][3] * m[2][1]) + m[0][1] * (m[1][3] * m[2][0] - m[1][0] * m[2][3]) + m[0][3] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]));
-	res.m[3][0] = -invdet * (m[1][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) + m[1][1] * (m[2][2] * m[3][0] - m[2][0] * m[3][2]) + m[1][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
-	res.m[3][1] = invdet  * (m[0][0] * (m[2][1] * m[3][2] - m[2][2] * m[3][1]) + m[0][1] * (m[2][2] * m[3][0] - m[2][0] * m[3][2]) + m[0][2] * (m[2][0] * m[3][1] - m[2][1] * m[3][0]));
-	res.m[3][2] = -invdet * (m[0][0] * (m[1][1] * m[3][2] - m[1][2] * m[3][1]) + m[0][1] * (m[1][2] * m[3][0] - m[1][0] * m[3][2]) + m[0][2] * (m[1][0] * m[3][1] - m[1][1] * m[3][0]));
-	res.m[3][3] = invdet  * (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) + m[0][1] * (m[1][2] * m[2][0] - m[1][0] * m[2][2]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])); 
-	*this = res;
-
-	return *this;
+        return *this;
+    }
+
+    *this = res;
+
+    return *this;
 }
 
-Quaternion::Quaternion(float _x, float _y, float _z, float _w)
+
+Matrix4f& Matrix4f::InverseAffine()
 {
-    x = _x;
-    y = _y;
-    z = _z;
-    w = _w;
+    // Inverse of the upper 3x3 through its cofactors. Everything is kept in
+    // locals and written back once: building a temporary Matrix4f and
+    // copying it over *this made -O3 builds slower than the general
+    // Inverse(), the vectorized copy stalling on the scalar stores.
+    const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+    const float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (det == 0.0f) {
+        // Matrix not invertible.
+        assert(0);
+        return *this;
+    }
+
+    const float invdet = 1.0f / det;
+
+    const float r00 = c00 * invdet;
+    const float r10 = c01 * invdet;
+    const float r20 = c02 * invdet;
+    const float r01 = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invdet;
+    const float r11 = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invdet;
+    const float r21 = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invdet;
+    const float r02 = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invdet;
+    const float r12 = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invdet;
+    const float r22 = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invdet;
+
+    // The translation becomes -A^-1 * t.
+    const float tx = m[0][3];
+    const float ty = m[1][3];
+    const float tz = m[2][3];
+
+    m[0][0] = r00; m[0][1] = r01; m[0][2] = r02; m[0][3] = -(r00 * tx + r01 * ty + r02 * tz);
+    m[1][0] = r10; m[1][1] = r11; m[1][2] = r12; m[1][3] = -(r10 * tx + r11 * ty + r12 * tz);
+    m[2][0] = r20; m[2][1] = r21; m[2][2] = r22; m[2][3] = -(r20 * tx + r21 * ty + r22 * tz);
+    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+
+    return *this;
+}
+
+
+Matrix4f& Matrix4f::InverseRigid()
+{
+    // The inverse of a rotation is its transpose, and the translation
+    // becomes -R^T * t. Written back once, as in InverseAffine().
+    const float r00 = m[0][0], r01 = m[1][0], r02 = m[2][0];
+    const float r10 = m[0][1], r11 = m[1][1], r12 = m[2][1];
+    const float r20 = m[0][2], r21 = m[1][2], r22 = m[2][2];
+    const float tx = m[0][3];
+    const float ty = m[1][3];
+    const float tz = m[2][3];
+
+    m[0][0] = r00; m[0][1] = r01; m[0][2] = r02; m[0][3] = -(r00 * tx + r01 * ty + r02 * tz);
+    m[1][0] = r10; m[1][1] = r11; m[1][2] = r12; m[1][3] = -(r10 * tx + r11 * ty + r12 * tz);
+    m[2][0] = r20; m[2][1] = r21; m[2][2] = r22; m[2][3] = -(r20 * tx + r21 * ty + r22 * tz);
+    m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+
+    return *this;
 }
 
 void Quaternion::Normalize()
@@ -282,6 +356,48 @@ Quaternion operator*(const Quaternion& q, const Vector3f& v)
 }
 
 
+Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    // q and -q are the same rotation; flip b to take the shortest arc.
+    const float s = a.Dot(b) < 0.0f ? -1.0f : 1.0f;
+
+    Quaternion ret(a.x + (s * b.x - a.x) * t,
+                   a.y + (s * b.y - a.y) * t,
+                   a.z + (s * b.z - a.z) * t,
+                   a.w + (s * b.w - a.w) * t);
+    ret.Normalize();
+
+    return ret;
+}
+
+Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+    float CosTheta = a.Dot(b);
+    float s = 1.0f;
+    if (CosTheta < 0.0f) {
+        CosTheta = -CosTheta;
+        s = -1.0f;
+    }
+
+    // sin(theta) gets too small to divide by.
+    if (CosTheta > 0.9995f) {
+        return Nlerp(a, b, t);
+    }
+
+    const float Theta = acosf(CosTheta);
+    const float InvSinTheta = 1.0f / sinf(Theta);
+    const float wa = sinf((1.0f - t) * Theta) * InvSinTheta;
+    const float wb = sinf(t * Theta) * InvSinTheta * s;
+
+    Quaternion ret(wa * a.x + wb * b.x,
+                   wa * a.y + wb * b.y,
+                   wa * a.z + wb * b.z,
+                   wa * a.w + wb * b.w);
+
+    return ret;
+}
+
+
 Vector3f Quaternion::ToDegrees()
 {
     float f[3];
@@ -300,8 +416,45 @@ Vector3f Quaternion::ToDegrees()
 
 float RandomFloat()
 {
-    float Max = RAND_MAX;
-    return ((float)RANDOM() / Max);
+    return ThreadRandom().NextFloat();
 }
 
 
+
+
+// Compile-time checks of the constexpr parts of the math types.
+
+static constexpr Matrix4f kTestIdentity = Matrix4f::Identity();
+static_assert(kTestIdentity.m[0][0] == 1.0f && kTestIdentity.m[1][1] == 1.0f &&
+              kTestIdentity.m[2][2] == 1.0f && kTestIdentity.m[3][3] == 1.0f &&
+              kTestIdentity.m[0][1] == 0.0f && kTestIdentity.m[3][0] == 0.0f,
+              "Matrix4f::Identity");
+
+static constexpr Matrix4f TestTransposedTranslation()
+{
+    Matrix4f t = Matrix4f::Identity();
+    t.InitTranslationTransform(1.0f, 2.0f, 3.0f);
+    return t.Transpose();
+}
+static_assert(TestTransposedTranslation().m[3][0] == 1.0f &&
+              TestTransposedTranslation().m[3][1] == 2.0f &&
+              TestTransposedTranslation().m[3][2] == 3.0f &&
+              TestTransposedTranslation().m[0][3] == 0.0f,
+              "Matrix4f::InitTranslationTransform / Transpose");
+
+static constexpr OrthoProjInfo kTestOrtho = { 800.0f, 0.0f, 0.0f, 600.0f, -1.0f, 1.0f };
+static constexpr Matrix4f kTestOrthoProj = Matrix4f::OrthoProjTransform(kTestOrtho);
+static_assert(kTestOrthoProj.m[0][0] == 2.0f / 800.0f && kTestOrthoProj.m[0][3] == -1.0f &&
+              kTestOrthoProj.m[1][1] == 2.0f / 600.0f && kTestOrthoProj.m[1][3] == -1.0f &&
+              kTestOrthoProj.m[2][2] == 1.0f && kTestOrthoProj.m[2][3] == 0.0f,
+              "Matrix4f::OrthoProjTransform");
+
+static constexpr Matrix4f kTestScale = Matrix4f::ScaleTransform(2.0f, 3.0f, 4.0f);
+static_assert(kTestScale.m[0][0] == 2.0f && kTestScale.m[1][1] == 3.0f &&
+              kTestScale.m[2][2] == 4.0f && kTestScale.m[3][3] == 1.0f,
+              "Matrix4f::ScaleTransform");
+
+static_assert((Vector3f(1.0f, 2.0f, 3.0f) + Vector3f(1.0f) * 2.0f).z == 5.0f, "Vector3f operators");
+static_assert((Vector4f(2.0f, 4.0f, 6.0f, 8.0f) / 2.0f).to3f().y == 2.0f, "Vector4f operators");
+static_assert(Vector2f(1.0f, 2.0f).y == 2.0f, "Vector2f");
+static_assert(Quaternion(0.0f, 0.0f, 0.0f, 1.0f).w == 1.0f, "Quaternion");
@@ -32,12 +32,26 @@
 #include <assimp/matrix4x4.h>
 
 #include "ogldev_util.h"
+#include "ogldev_simd.h"
+#include "ogldev_aligned.h"
 
 #define ToRadian(x) (float)(((x) * M_PI / 180.0f))
 #define ToDegree(x) (float)(((x) * 180.0f / M_PI))
 
+// Uniform in [0, 1). Thread safe, see ThreadRandom() in ogldev_random.h.
 float RandomFloat();
 
+// sinf and cosf of the same angle in one call where the C library has it.
+inline void SinCos(float Angle, float& Sin, float& Cos)
+{
+#if defined(__GLIBC__)
+    sincosf(Angle, &Sin, &Cos);
+#else
+    Sin = sinf(Angle);
+    Cos = cosf(Angle);
+#endif
+}
+
 struct Vector2i
 {
     int x;
@@ -53,10 +67,9 @@ struct Vector2f
     {
     }
 
-    Vector2f(float _x, float _y)
+    constexpr Vector2f(float _x, float _y)
+        : x(_x), y(_y)
     {
-        x = _x;
-        y = _y;
     }
 };
 
@@ -69,26 +82,22 @@ struct Vector3f
 
     Vector3f() {}
 
-    Vector3f(float _x, float _y, float _z)
+    constexpr Vector3f(float _x, float _y, float _z)
+        : x(_x), y(_y), z(_z)
     {
-        x = _x;
-        y = _y;
-        z = _z;
     }
 
-    Vector3f(const float* pFloat)
+    constexpr Vector3f(const float* pFloat)
+        : x(pFloat[0]), y(pFloat[1]), z(pFloat[2])
     {
-        x = pFloat[0];
-        y = pFloat[0];
-        z = pFloat[0];
     }
 
-    Vector3f(float f)
+    constexpr Vector3f(float f)
+        : x(f), y(f), z(f)
     {
-        x = y = z = f;
     }
 
-    Vector3f& operator+=(const Vector3f& r)
+    constexpr Vector3f& operator+=(const Vector3f& r)
     {
         x += r.x;
         y += r.y;
@@ -97,7 +106,7 @@ struct Vector3f
         return *this;
     }
 
-    Vector3f& operator-=(const Vector3f& r)
+    constexpr Vector3f& operator-=(const Vector3f& r)
     {
         x -= r.x;
         y -= r.y;
@@ -106,7 +115,7 @@ struct Vector3f
         return *this;
     }
 
-    Vector3f& operator*=(float f)
+    constexpr Vector3f& operator*=(float f)
     {
         x *= f;
         y *= f;
@@ -134,7 +143,8 @@ struct Vector3f
 };
 
 
-struct Vector4f
+// 16-byte aligned so it can be loaded into one SIMD register.
+struct alignas(16) Vector4f
 {
     float x;
     float y;
@@ -145,12 +155,9 @@ struct Vector4f
     {
     }
 
-    Vector4f(float _x, float _y, float _z, float _w)
+    constexpr Vector4f(float _x, float _y, float _z, float _w)
+        : x(_x), y(_y), z(_z), w(_w)
     {
-        x = _x;
-        y = _y;
-        z = _z;
-        w = _w;
     }
 
     void Print(bool endl = true) const
@@ -162,16 +169,15 @@ struct Vector4f
         }
     }
 
-    Vector3f to3f() const
+    constexpr Vector3f to3f() const
     {
-        Vector3f v(x, y, z);
-        return v;
+        return Vector3f(x, y, z);
     }
 };
 
 
 
-inline Vector3f operator+(const Vector3f& l, const Vector3f& r)
+constexpr Vector3f operator+(const Vector3f& l, const Vector3f& r)
 {
     Vector3f Ret(l.x + r.x,
                  l.y + r.y,
@@ -180,7 +186,7 @@ inline Vector3f operator+(const Vector3f& l, const Vector3f& r)
     return Ret;
 }
 
-inline Vector3f operator-(const Vector3f& l, const Vector3f& r)
+constexpr Vector3f operator-(const Vector3f& l, const Vector3f& r)
 {
     Vector3f Ret(l.x - r.x,
                  l.y - r.y,
@@ -189,7 +195,7 @@ inline Vector3f operator-(const Vector3f& l, const Vector3f& r)
     return Ret;
 }
 
-inline Vector3f operator*(const Vector3f& l, float f)
+constexpr Vector3f operator*(const Vector3f& l, float f)
 {
     Vector3f Ret(l.x * f,
                  l.y * f,
@@ -199,7 +205,7 @@ inline Vector3f operator*(const Vector3f& l, float f)
 }
 
 
-inline Vector4f operator/(const Vector4f& l, float f)
+constexpr Vector4f operator/(const Vector4f& l, float f)
 {
     Vector4f Ret(l.x / f,
                  l.y / f,
@@ -230,25 +236,43 @@ struct OrthoProjInfo
     float f;        // z far
 };
 
-struct Quaternion
+struct alignas(16) Quaternion
 {
     float x, y, z, w;
 
-    Quaternion(float _x, float _y, float _z, float _w);
+    Quaternion()
+    {
+    }
+
+    constexpr Quaternion(float _x, float _y, float _z, float _w)
+        : x(_x), y(_y), z(_z), w(_w)
+    {
+    }
 
     void Normalize();
 
     Quaternion Conjugate();
 
+    constexpr float Dot(const Quaternion& q) const
+    {
+        return x * q.x + y * q.y + z * q.z + w * q.w;
+    }
+
     Vector3f ToDegrees();
  };
 
 
-class Matrix4f
+// Rows are 16-byte aligned. Use AlignedVector<Matrix4f> (ogldev_aligned.h)
+// for bulk buffers so each matrix occupies exactly one cache line; the SIMD
+// code still uses unaligned loads because a plain std::vector<Matrix4f> only
+// gets malloc alignment before C++17.
+class alignas(16) Matrix4f
 {
 public:
     float m[4][4];
 
+    OGLDEV_ALIGNED_OPERATOR_NEW(Matrix4f)
+
     Matrix4f()
     {
     }
@@ -270,68 +294,142 @@ public:
         m[3][0] = 0.0f           ; m[3][1] = 0.0f           ; m[3][2] = 0.0f           ; m[3][3] = 1.0f;
     }
 
-    Matrix4f(float a00, float a01, float a02, float a03,
-             float a10, float a11, float a12, float a13,
-             float a20, float a21, float a22, float a23,
-             float a30, float a31, float a32, float a33)
+    constexpr Matrix4f(float a00, float a01, float a02, float a03,
+                       float a10, float a11, float a12, float a13,
+                       float a20, float a21, float a22, float a23,
+                       float a30, float a31, float a32, float a33)
+        : m{{a00, a01, a02, a03},
+            {a10, a11, a12, a13},
+            {a20, a21, a22, a23},
+            {a30, a31, a32, a33}}
     {
-        m[0][0] = a00; m[0][1] = a01; m[0][2] = a02; m[0][3] = a03;
-        m[1][0] = a10; m[1][1] = a11; m[1][2] = a12; m[1][3] = a13;
-        m[2][0] = a20; m[2][1] = a21; m[2][2] = a22; m[2][3] = a23;
-        m[3][0] = a30; m[3][1] = a31; m[3][2] = a32; m[3][3] = a33;
     }
 
-    void SetZero()
+    // Compile-time factories. The matching Init* functions below are
+    // constexpr too, so fixed transforms can be baked into read-only data:
+    //
+    //     constexpr Matrix4f HudProj = Matrix4f::OrthoProjTransform({1, -1, -1, 1, -1, 1});
+
+    static constexpr Matrix4f Zero()
     {
-        ZERO_MEM(m);
+        return Matrix4f(0.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 0.0f);
     }
 
-    Matrix4f Transpose() const
+    static constexpr Matrix4f Identity()
     {
-        Matrix4f n;
+        return Matrix4f(1.0f, 0.0f, 0.0f, 0.0f,
+                        0.0f, 1.0f, 0.0f, 0.0f,
+                        0.0f, 0.0f, 1.0f, 0.0f,
+                        0.0f, 0.0f, 0.0f, 1.0f);
+    }
 
-        for (unsigned int i = 0 ; i < 4 ; i++) {
-            for (unsigned int j = 0 ; j < 4 ; j++) {
-                n.m[i][j] = m[j][i];
-            }
-        }
+    static constexpr Matrix4f ScaleTransform(float ScaleX, float ScaleY, float ScaleZ)
+    {
+        return Matrix4f(ScaleX, 0.0f,   0.0f,   0.0f,
+                        0.0f,   ScaleY, 0.0f,   0.0f,
+                        0.0f,   0.0f,   ScaleZ, 0.0f,
+                        0.0f,   0.0f,   0.0f,   1.0f);
+    }
+
+    static constexpr Matrix4f TranslationTransform(float x, float y, float z)
+    {
+        return Matrix4f(1.0f, 0.0f, 0.0f, x,
+                        0.0f, 1.0f, 0.0f, y,
+                        0.0f, 0.0f, 1.0f, z,
+                        0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    static constexpr Matrix4f OrthoProjTransform(const OrthoProjInfo& p)
+    {
+        return Matrix4f(2.0f/(p.r - p.l), 0.0f,             0.0f,             -(p.r + p.l)/(p.r - p.l),
+                        0.0f,             2.0f/(p.t - p.b), 0.0f,             -(p.t + p.b)/(p.t - p.b),
+                        0.0f,             0.0f,             2.0f/(p.f - p.n), -(p.f + p.n)/(p.f - p.n),
+                        0.0f,             0.0f,             0.0f,             1.0f);
+    }
 
-        return n;
+    constexpr void SetZero()
+    {
+        *this = Zero();
+    }
+
+    constexpr Matrix4f Transpose() const
+    {
+        return Matrix4f(m[0][0], m[1][0], m[2][0], m[3][0],
+                        m[0][1], m[1][1], m[2][1], m[3][1],
+                        m[0][2], m[1][2], m[2][2], m[3][2],
+                        m[0][3], m[1][3], m[2][3], m[3][3]);
     }
 
 
-    inline void InitIdentity()
+    constexpr void InitIdentity()
     {
-        m[0][0] = 1.0f; m[0][1] = 0.0f; m[0][2] = 0.0f; m[0][3] = 0.0f;
-        m[1][0] = 0.0f; m[1][1] = 1.0f; m[1][2] = 0.0f; m[1][3] = 0.0f;
-        m[2][0] = 0.0f; m[2][1] = 0.0f; m[2][2] = 1.0f; m[2][3] = 0.0f;
-        m[3][0] = 0.0f; m[3][1] = 0.0f; m[3][2] = 0.0f; m[3][3] = 1.0f;
+        *this = Identity();
     }
 
+    // Row i of the product is sum(m[i][k] * Right.row(k)). Each lane is
+    // accumulated in the same order as the scalar formula
+    // ((p0 + p1) + p2) + p3, so the SIMD paths are bit-identical to the
+    // scalar fallback. If the compiler contracts the scalar code into FMA
+    // (e.g. -mfma -ffp-contract=fast) the two may differ by at most 2 ULP
+    // per element.
     inline Matrix4f operator*(const Matrix4f& Right) const
     {
         Matrix4f Ret;
 
+#if defined(OGLDEV_SIMD_AVX)
+        // Two result rows per iteration: the low lane handles row i, the
+        // high lane row i + 1.
+        const __m256 r0 = _mm256_broadcast_ps((const __m128*)Right.m[0]);
+        const __m256 r1 = _mm256_broadcast_ps((const __m128*)Right.m[1]);
+        const __m256 r2 = _mm256_broadcast_ps((const __m128*)Right.m[2]);
+        const __m256 r3 = _mm256_broadcast_ps((const __m128*)Right.m[3]);
+
+        for (unsigned int i = 0 ; i < 4 ; i += 2) {
+            const __m256 a = _mm256_loadu_ps(m[i]);
+            __m256 acc = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), r0);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x55), r1));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xAA), r2));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0xFF), r3));
+            _mm256_storeu_ps(Ret.m[i], acc);
+        }
+#else
+        const simd::Float4 r0 = simd::Load4(Right.m[0]);
+        const simd::Float4 r1 = simd::Load4(Right.m[1]);
+        const simd::Float4 r2 = simd::Load4(Right.m[2]);
+        const simd::Float4 r3 = simd::Load4(Right.m[3]);
+
         for (unsigned int i = 0 ; i < 4 ; i++) {
-            for (unsigned int j = 0 ; j < 4 ; j++) {
-                Ret.m[i][j] = m[i][0] * Right.m[0][j] +
-                              m[i][1] * Right.m[1][j] +
-                              m[i][2] * Right.m[2][j] +
-                              m[i][3] * Right.m[3][j];
-            }
+            simd::Float4 acc = simd::Mul4(simd::Splat4(m[i][0]), r0);
+            acc = simd::Add4(acc, simd::Mul4(simd::Splat4(m[i][1]), r1));
+            acc = simd::Add4(acc, simd::Mul4(simd::Splat4(m[i][2]), r2));
+            acc = simd::Add4(acc, simd::Mul4(simd::Splat4(m[i][3]), r3));
+            simd::Store4(Ret.m[i], acc);
         }
+#endif
 
         return Ret;
     }
 
+    // Computed as sum(column(k) * v[k]) on the transposed rows, which keeps
+    // the scalar summation order (see operator*(const Matrix4f&)).
     Vector4f operator*(const Vector4f& v) const
     {
-        Vector4f r;
+        simd::Float4 c0 = simd::Load4(m[0]);
+        simd::Float4 c1 = simd::Load4(m[1]);
+        simd::Float4 c2 = simd::Load4(m[2]);
+        simd::Float4 c3 = simd::Load4(m[3]);
+        simd::Transpose4(c0, c1, c2, c3);
+
+        simd::Float4 acc = simd::Mul4(c0, simd::Splat4(v.x));
+        acc = simd::Add4(acc, simd::Mul4(c1, simd::Splat4(v.y)));
+        acc = simd::Add4(acc, simd::Mul4(c2, simd::Splat4(v.z)));
+        acc = simd::Add4(acc, simd::Mul4(c3, simd::Splat4(v.w)));
 
-        r.x = m[0][0]* v.x + m[0][1]* v.y + m[0][2]* v.z + m[0][3]* v.w;
-        r.y = m[1][0]* v.x + m[1][1]* v.y + m[1][2]* v.z + m[1][3]* v.w;
-        r.z = m[2][0]* v.x + m[2][1]* v.y + m[2][2]* v.z + m[2][3]* v.w;
-        r.w = m[3][0]* v.x + m[3][1]* v.y + m[3][2]* v.z + m[3][3]* v.w;
+        Vector4f r;
+        simd::Store4(&r.x, acc);
 
         return r;
     }
@@ -350,20 +448,59 @@ public:
 
     float Determinant() const;
 
+    // General inverse. Asserts if the matrix is singular.
     Matrix4f& Inverse();
 
-    void InitScaleTransform(float ScaleX, float ScaleY, float ScaleZ);
+    // General inverse without the assert. Returns false and leaves Result
+    // untouched if the matrix is singular.
+    bool TryInverse(Matrix4f& Result) const;
+
+    // Inverse of an affine matrix (last row is 0 0 0 1), e.g. any product of
+    // InitScaleTransform, InitRotateTransform and InitTranslationTransform.
+    Matrix4f& InverseAffine();
+
+    // Inverse of a rigid transform (rotation + translation only), e.g. a
+    // camera. The rotation part is simply transposed.
+    Matrix4f& InverseRigid();
+
+    constexpr void InitScaleTransform(float ScaleX, float ScaleY, float ScaleZ)
+    {
+        *this = ScaleTransform(ScaleX, ScaleY, ScaleZ);
+    }
+
     void InitRotateTransform(float RotateX, float RotateY, float RotateZ);
     void InitRotateTransform(const Quaternion& quat);
-    void InitTranslationTransform(float x, float y, float z);
+    // Translation * Rotation * Scale written directly in closed form.
+    // Rotation is in degrees, with the same convention as
+    // InitRotateTransform (rz * ry * rx).
+    void InitTRS(const Vector3f& Translation, const Vector3f& Rotation, const Vector3f& Scale);
+    void InitTRS(const Vector3f& Translation, const Quaternion& Rotation, const Vector3f& Scale);
+
+    constexpr void InitTranslationTransform(float x, float y, float z)
+    {
+        *this = TranslationTransform(x, y, z);
+    }
+
     void InitCameraTransform(const Vector3f& Target, const Vector3f& Up);
     void InitPersProjTransform(const PersProjInfo& p);
-    void InitOrthoProjTransform(const OrthoProjInfo& p);
+
+    constexpr void InitOrthoProjTransform(const OrthoProjInfo& p)
+    {
+        *this = OrthoProjTransform(p);
+    }
 };
 
 Quaternion operator*(const Quaternion& l, const Quaternion& r);
 
 Quaternion operator*(const Quaternion& q, const Vector3f& v);
 
+// Normalized linear interpolation along the shortest arc. Cheap, but the
+// angular speed is not constant across t.
+Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);
+
+// Spherical linear interpolation along the shortest arc, at constant
+// angular speed. Falls back to Nlerp when a and b are nearly parallel.
+Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
 #endif	/* MATH_3D_H */
 
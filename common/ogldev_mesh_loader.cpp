@@ -0,0 +1,930 @@
+#include "ogldev_mesh_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "ogldev_mapped_file.h"
+#include "ogldev_profiler.h"
+#include "ogldev_util.h"
+
+// OBJ files are cut into this many chunks per thread, so that a thread
+// that finishes early can take another one.
+static const unsigned kChunksPerThread = 4;
+// Smaller chunks cost more in thread overhead than they save.
+static const size_t kMinChunkSize = 1 << 20;
+// ASCII PLY rows handed to a thread at a time.
+static const size_t kRowsPerBlock = 16384;
+
+static const u32 kNone = 0xffffffff;
+
+static unsigned ThreadCount(unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return thread_count;
+}
+
+// Calls fn(i) for every i in [0, count) on up to |thread_count| threads.
+template <typename Fn>
+static void ParallelFor(size_t count, unsigned thread_count, const Fn& fn) {
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) fn(i);
+  };
+
+  std::vector<std::thread> threads;
+  const size_t extra = std::min<size_t>(thread_count, count);
+  for (size_t t = 1; t < extra; t++) threads.emplace_back(worker);
+  worker();
+  for (std::thread& t : threads) t.join();
+}
+
+static bool IsDigit(char c) {
+  return static_cast<unsigned>(c - '0') < 10;
+}
+
+static bool IsBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char* SkipBlanks(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) p++;
+  return p;
+}
+
+static const char* LineEnd(const char* p, const char* end) {
+  const void* nl = memchr(p, '\n', end - p);
+  return nl ? static_cast<const char*>(nl) : end;
+}
+
+// Powers of ten that are exact in a double.
+static const double kPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Parses a decimal number after optional blanks, whatever the C locale.
+// The first 19 significant digits are kept and scaled by one exact power
+// of ten when possible, which is within an ulp of strtod and several times
+// faster. Returns the character after the number, or null if there is no
+// number at |p|.
+static const char* ParseNumber(const char* p, const char* end, double* out) {
+  p = SkipBlanks(p, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  u64 mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any = false;
+  for (; p < end && IsDigit(*p); p++) {
+    any = true;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa != 0) digits++;
+    } else {
+      exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && IsDigit(*p); p++) {
+      any = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0) digits++;
+        exponent--;
+      }
+    }
+  }
+  if (!any) return nullptr;
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool exp_negative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      exp_negative = *q == '-';
+      q++;
+    }
+    if (q < end && IsDigit(*q)) {
+      int e = 0;
+      for (; q < end && IsDigit(*q); q++) {
+        if (e < 10000) e = e * 10 + (*q - '0');
+      }
+      exponent += exp_negative ? -e : e;
+      p = q;
+    }
+  }
+
+  double v = static_cast<double>(mantissa);
+  if (mantissa != 0 && exponent != 0) {
+    if (exponent > 0 && exponent <= 22) {
+      v *= kPow10[exponent];
+    } else if (exponent < 0 && exponent >= -22) {
+      v /= kPow10[-exponent];
+    } else {
+      v *= std::pow(10.0, exponent);
+    }
+  }
+  *out = negative ? -v : v;
+  return p;
+}
+
+static const char* ParseFloat(const char* p, const char* end, float* out) {
+  double v;
+  p = ParseNumber(p, end, &v);
+  if (p) *out = static_cast<float>(v);
+  return p;
+}
+
+// A decimal integer with an optional minus sign, without leading blanks.
+// Values beyond the i32 range saturate, so they fail any range check.
+static const char* ParseInt(const char* p, const char* end, i32* out) {
+  bool negative = false;
+  if (p < end && *p == '-') {
+    negative = true;
+    p++;
+  }
+  if (p == end || !IsDigit(*p)) return nullptr;
+  i64 v = 0;
+  for (; p < end && IsDigit(*p); p++) {
+    if (v <= 0x7fffffff) v = v * 10 + (*p - '0');
+  }
+  v = std::min<i64>(v, 0x7fffffff);
+  *out = static_cast<i32>(negative ? -v : v);
+  return p;
+}
+
+// Area-weighted vertex normals. position_of(i) gives the position index of
+// index buffer entry i; vertices sharing a position share the normal.
+template <typename PositionOf>
+static void SmoothNormals(const Vector3f* positions, size_t position_count,
+                          size_t index_count, const PositionOf& position_of,
+                          std::vector<Vector3f>& normals) {
+  OGLDEV_PROFILE_FUNCTION();
+  normals.assign(position_count, Vector3f(0.0f));
+  for (size_t i = 0; i + 2 < index_count; i += 3) {
+    const u32 a = position_of(i);
+    const u32 b = position_of(i + 1);
+    const u32 c = position_of(i + 2);
+    // The cross product length is twice the area, hence the weighting.
+    const Vector3f n =
+        (positions[b] - positions[a]).Cross(positions[c] - positions[a]);
+    normals[a] += n;
+    normals[b] += n;
+    normals[c] += n;
+  }
+  for (Vector3f& n : normals) {
+    const float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    n = length > 0.0f ? n * (1.0f / length) : Vector3f(0.0f, 0.0f, 1.0f);
+  }
+}
+
+//
+// OBJ
+//
+
+// One face corner as written in the file, 1-based. An index flagged in
+// |relative| was negative in the file and has already been turned into a
+// 0-based index relative to the start of the chunk. 0 without the flag
+// means the attribute is absent.
+struct ObjCorner {
+  i32 index[3];  // Position, texture coordinate, normal.
+  u32 relative;  // Bit i set if index[i] is chunk relative.
+};
+
+struct ObjChunk {
+  const char* begin;
+  const char* end;
+  std::vector<Vector3f> positions;
+  std::vector<Vector2f> tex_coords;
+  std::vector<Vector3f> normals;
+  std::vector<ObjCorner> corners;  // Three per triangle.
+  const char* error;               // First malformed line, or null.
+};
+
+static bool ParseObjFace(const char* p, const char* end, ObjChunk& chunk) {
+  const i32 counts[3] = {static_cast<i32>(chunk.positions.size()),
+                         static_cast<i32>(chunk.tex_coords.size()),
+                         static_cast<i32>(chunk.normals.size())};
+  ObjCorner first = {};
+  ObjCorner prev = {};
+  int n = 0;
+  for (;;) {
+    p = SkipBlanks(p, end);
+    if (p == end) break;
+
+    // v, v/vt, v//vn or v/vt/vn.
+    ObjCorner c = {};
+    p = ParseInt(p, end, &c.index[0]);
+    if (!p || c.index[0] == 0) return false;
+    if (p < end && *p == '/') {
+      p++;
+      if (p < end && *p != '/') {
+        p = ParseInt(p, end, &c.index[1]);
+        if (!p || c.index[1] == 0) return false;
+      }
+      if (p < end && *p == '/') {
+        p = ParseInt(p + 1, end, &c.index[2]);
+        if (!p || c.index[2] == 0) return false;
+      }
+    }
+    if (p < end && !IsBlank(*p)) return false;
+
+    for (int i = 0; i < 3; i++) {
+      if (c.index[i] < 0) {
+        c.index[i] += counts[i];
+        c.relative |= 1u << i;
+      }
+    }
+
+    // Fan triangulation.
+    if (n == 0) {
+      first = c;
+    } else if (n >= 2) {
+      chunk.corners.push_back(first);
+      chunk.corners.push_back(prev);
+      chunk.corners.push_back(c);
+    }
+    prev = c;
+    n++;
+  }
+  // Points and lines are not part of a triangle mesh.
+  return true;
+}
+
+static void ParseObjChunk(ObjChunk& chunk) {
+  const char* p = chunk.begin;
+  while (p < chunk.end) {
+    const char* line_end = LineEnd(p, chunk.end);
+    // Comments run to the end of the line, also after a statement.
+    const void* comment = memchr(p, '#', line_end - p);
+    const char* end = comment ? static_cast<const char*>(comment) : line_end;
+    const char* line = SkipBlanks(p, end);
+    bool ok = true;
+    if (end - line >= 2 && line[0] == 'v' && IsBlank(line[1])) {
+      Vector3f v;
+      ok = (line = ParseFloat(line + 1, end, &v.x)) &&
+           (line = ParseFloat(line, end, &v.y)) &&
+           ParseFloat(line, end, &v.z);
+      chunk.positions.push_back(v);
+    } else if (end - line >= 3 && line[0] == 'v' && line[1] == 't' &&
+               IsBlank(line[2])) {
+      Vector2f t(0.0f, 0.0f);
+      ok = (line = ParseFloat(line + 2, end, &t.x)) != nullptr;
+      if (ok) ParseFloat(line, end, &t.y);  // v is optional.
+      chunk.tex_coords.push_back(t);
+    } else if (end - line >= 3 && line[0] == 'v' && line[1] == 'n' &&
+               IsBlank(line[2])) {
+      Vector3f n;
+      ok = (line = ParseFloat(line + 2, end, &n.x)) &&
+           (line = ParseFloat(line, end, &n.y)) &&
+           ParseFloat(line, end, &n.z);
+      chunk.normals.push_back(n);
+    } else if (end - line >= 2 && line[0] == 'f' && IsBlank(line[1])) {
+      ok = ParseObjFace(line + 1, end, chunk);
+    }
+    if (!ok) {
+      chunk.error = p;
+      return;
+    }
+    p = line_end + 1;
+  }
+}
+
+// Splits [data, data + size) into about |count| chunks ending after a
+// newline.
+static std::vector<ObjChunk> SplitChunks(const char* data, size_t size,
+                                         size_t count) {
+  std::vector<ObjChunk> chunks(count);
+  const char* end = data + size;
+  const char* p = data;
+  for (size_t i = 0; i < count; i++) {
+    const char* chunk_end = end;
+    if (i + 1 < count) {
+      chunk_end = std::max(p, data + size / count * (i + 1));
+      chunk_end = std::min(LineEnd(chunk_end, end) + 1, end);
+    }
+    chunks[i].begin = p;
+    chunks[i].end = chunk_end;
+    chunks[i].error = nullptr;
+    p = chunk_end;
+  }
+  return chunks;
+}
+
+bool LoadObj(const char* fileName, MeshData& mesh, unsigned thread_count) {
+  OGLDEV_PROFILE_FUNCTION();
+  mesh = MeshData();
+  thread_count = ThreadCount(thread_count);
+
+  MappedFile file;
+  if (!file.Open(fileName, MappedFile::kAccessSequential)) {
+    return false;
+  }
+
+  const size_t chunk_count = std::max<size_t>(
+      1, std::min<size_t>(thread_count * kChunksPerThread,
+                          file.size() / kMinChunkSize));
+  std::vector<ObjChunk> chunks =
+      SplitChunks(file.data(), file.size(), chunk_count);
+  ParallelFor(chunks.size(), thread_count,
+              [&chunks](size_t i) { ParseObjChunk(chunks[i]); });
+
+  // Where each chunk's attributes start in the whole file.
+  std::vector<u64> bases(chunks.size() * 3);
+  u64 totals[3] = {0, 0, 0};
+  u64 corner_count = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const ObjChunk& c = chunks[i];
+    if (c.error) {
+      OGLDEV_ERROR("'%s': malformed OBJ line at byte %llu\n", fileName,
+                   static_cast<unsigned long long>(c.error - file.data()));
+      return false;
+    }
+    for (int k = 0; k < 3; k++) bases[i * 3 + k] = totals[k];
+    totals[0] += c.positions.size();
+    totals[1] += c.tex_coords.size();
+    totals[2] += c.normals.size();
+    corner_count += c.corners.size();
+  }
+  if (totals[0] >= kNone || corner_count >= kNone) {
+    OGLDEV_ERROR("'%s': too many vertices\n", fileName);
+    return false;
+  }
+
+  std::vector<Vector3f> positions(totals[0]);
+  std::vector<Vector2f> tex_coords(totals[1]);
+  std::vector<Vector3f> normals(totals[2]);
+  ParallelFor(chunks.size(), thread_count, [&](size_t i) {
+    const ObjChunk& c = chunks[i];
+    std::copy(c.positions.begin(), c.positions.end(),
+              positions.begin() + bases[i * 3]);
+    std::copy(c.tex_coords.begin(), c.tex_coords.end(),
+              tex_coords.begin() + bases[i * 3 + 1]);
+    std::copy(c.normals.begin(), c.normals.end(),
+              normals.begin() + bases[i * 3 + 2]);
+  });
+
+  // Joins identical corners. Each position heads a short list of the
+  // (texture coordinate, normal) pairs seen with it, so no hashing is
+  // needed and vertices are numbered in order of first use.
+  struct Key {
+    u32 index[3];
+  };
+  std::vector<Key> keys;
+  std::vector<u32> next;
+  std::vector<u32> head(totals[0], kNone);
+  keys.reserve(totals[0]);
+  next.reserve(totals[0]);
+  mesh.indices.resize(corner_count);
+
+  size_t out = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    for (const ObjCorner& c : chunks[i].corners) {
+      Key key;
+      for (int k = 0; k < 3; k++) {
+        i64 index = c.index[k];
+        if (c.relative & (1u << k)) {
+          index += bases[i * 3 + k];
+        } else if (index > 0) {
+          index--;
+        } else if (k > 0) {
+          key.index[k] = kNone;
+          continue;
+        }
+        if (index < 0 || static_cast<u64>(index) >= totals[k]) {
+          OGLDEV_ERROR("'%s': OBJ face index out of range\n", fileName);
+          mesh = MeshData();
+          return false;
+        }
+        key.index[k] = static_cast<u32>(index);
+      }
+
+      u32 id = head[key.index[0]];
+      while (id != kNone && (keys[id].index[1] != key.index[1] ||
+                             keys[id].index[2] != key.index[2])) {
+        id = next[id];
+      }
+      if (id == kNone) {
+        id = static_cast<u32>(keys.size());
+        keys.push_back(key);
+        next.push_back(head[key.index[0]]);
+        head[key.index[0]] = id;
+      }
+      mesh.indices[out++] = id;
+    }
+    std::vector<ObjCorner>().swap(chunks[i].corners);
+  }
+
+  mesh.has_tex_coords = !tex_coords.empty();
+  mesh.has_normals = !normals.empty();
+  if (!mesh.has_normals) {
+    SmoothNormals(positions.data(), positions.size(), mesh.indices.size(),
+                  [&](size_t i) { return keys[mesh.indices[i]].index[0]; },
+                  normals);
+  }
+
+  mesh.vertices.resize(keys.size());
+  const size_t block = 65536;
+  ParallelFor((keys.size() + block - 1) / block, thread_count, [&](size_t b) {
+    const size_t last = std::min(keys.size(), (b + 1) * block);
+    for (size_t i = b * block; i < last; i++) {
+      const Key& k = keys[i];
+      MeshVertex& v = mesh.vertices[i];
+      v.pos = positions[k.index[0]];
+      v.tex = k.index[1] != kNone ? tex_coords[k.index[1]] : Vector2f(0, 0);
+      if (!mesh.has_normals) {
+        v.normal = normals[k.index[0]];
+      } else if (k.index[2] != kNone) {
+        v.normal = normals[k.index[2]];
+      } else {
+        v.normal = Vector3f(0.0f);
+      }
+    }
+  });
+  return true;
+}
+
+//
+// PLY
+//
+
+enum PlyType {
+  kPlyInt8,
+  kPlyUint8,
+  kPlyInt16,
+  kPlyUint16,
+  kPlyInt32,
+  kPlyUint32,
+  kPlyFloat32,
+  kPlyFloat64,
+  kPlyInvalid,
+};
+
+static const size_t kPlyTypeSize[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+enum PlyFormat {
+  kPlyAscii,
+  kPlyBinaryLittleEndian,
+  kPlyBinaryBigEndian,
+};
+
+struct PlyProperty {
+  std::string name;
+  PlyType type;
+  bool is_list;
+  PlyType count_type;  // For lists.
+};
+
+struct PlyElement {
+  std::string name;
+  u64 count;
+  std::vector<PlyProperty> properties;
+
+  // Size of one row, or 0 if it holds a list.
+  size_t FixedSize() const {
+    size_t size = 0;
+    for (const PlyProperty& p : properties) {
+      if (p.is_list) return 0;
+      size += kPlyTypeSize[p.type];
+    }
+    return size;
+  }
+
+  int Find(const char* const* names) const {
+    for (; *names; names++) {
+      for (size_t i = 0; i < properties.size(); i++) {
+        if (properties[i].name == *names) return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+};
+
+static PlyType PlyTypeFromName(const std::string& name) {
+  static const char* const kNames[][2] = {
+      {"char", "int8"},   {"uchar", "uint8"},   {"short", "int16"},
+      {"ushort", "uint16"}, {"int", "int32"},   {"uint", "uint32"},
+      {"float", "float32"}, {"double", "float64"}};
+  for (int t = 0; t < kPlyInvalid; t++) {
+    if (name == kNames[t][0] || name == kNames[t][1]) {
+      return static_cast<PlyType>(t);
+    }
+  }
+  return kPlyInvalid;
+}
+
+// Reads one binary value; |p| has at least kPlyTypeSize[type] bytes.
+static double ReadPlyValue(const char* p, PlyType type, bool swap) {
+  char bytes[8];
+  const size_t size = kPlyTypeSize[type];
+  if (swap) {
+    for (size_t i = 0; i < size; i++) bytes[i] = p[size - 1 - i];
+  } else {
+    memcpy(bytes, p, size);
+  }
+  switch (type) {
+    case kPlyInt8: return static_cast<i8>(bytes[0]);
+    case kPlyUint8: return static_cast<u8>(bytes[0]);
+    case kPlyInt16: { i16 v; memcpy(&v, bytes, 2); return v; }
+    case kPlyUint16: { u16 v; memcpy(&v, bytes, 2); return v; }
+    case kPlyInt32: { i32 v; memcpy(&v, bytes, 4); return v; }
+    case kPlyUint32: { u32 v; memcpy(&v, bytes, 4); return v; }
+    case kPlyFloat32: { float v; memcpy(&v, bytes, 4); return v; }
+    case kPlyFloat64: { double v; memcpy(&v, bytes, 8); return v; }
+    default: return 0.0;
+  }
+}
+
+// Parses the header up to and including "end_header" and returns the
+// offset of the body, or 0 if the header is malformed.
+static size_t ParsePlyHeader(const char* data, size_t size, PlyFormat* format,
+                             std::vector<PlyElement>& elements) {
+  const char* p = data;
+  const char* end = data + size;
+  bool have_format = false;
+  bool first = true;
+  while (p < end) {
+    const char* line_end = LineEnd(p, end);
+    std::vector<std::string> words;
+    for (const char* q = p; q < line_end;) {
+      q = SkipBlanks(q, line_end);
+      const char* w = q;
+      while (q < line_end && !IsBlank(*q)) q++;
+      if (q > w) words.emplace_back(w, q);
+    }
+    p = line_end + 1;
+
+    if (first) {
+      if (words.size() != 1 || words[0] != "ply") return 0;
+      first = false;
+      continue;
+    }
+    if (words.empty() || words[0] == "comment" || words[0] == "obj_info") {
+      continue;
+    }
+    if (words[0] == "end_header") {
+      return have_format && p <= end ? p - data : 0;
+    }
+    if (words[0] == "format" && words.size() >= 2) {
+      if (words[1] == "ascii") {
+        *format = kPlyAscii;
+      } else if (words[1] == "binary_little_endian") {
+        *format = kPlyBinaryLittleEndian;
+      } else if (words[1] == "binary_big_endian") {
+        *format = kPlyBinaryBigEndian;
+      } else {
+        return 0;
+      }
+      have_format = true;
+    } else if (words[0] == "element" && words.size() == 3) {
+      PlyElement e;
+      e.name = words[1];
+      double count;
+      const char* w = words[2].c_str();
+      if (ParseNumber(w, w + words[2].size(), &count) == nullptr ||
+          count < 0) {
+        return 0;
+      }
+      e.count = static_cast<u64>(count);
+      elements.push_back(e);
+    } else if (words[0] == "property" && !elements.empty()) {
+      PlyProperty prop;
+      if (words.size() == 5 && words[1] == "list") {
+        prop.is_list = true;
+        prop.count_type = PlyTypeFromName(words[2]);
+        prop.type = PlyTypeFromName(words[3]);
+        prop.name = words[4];
+        if (prop.count_type == kPlyInvalid ||
+            prop.count_type >= kPlyFloat32) {
+          return 0;
+        }
+      } else if (words.size() == 3) {
+        prop.is_list = false;
+        prop.count_type = kPlyInvalid;
+        prop.type = PlyTypeFromName(words[1]);
+        prop.name = words[2];
+      } else {
+        return 0;
+      }
+      if (prop.type == kPlyInvalid) return 0;
+      elements.back().properties.push_back(prop);
+    } else {
+      return 0;
+    }
+  }
+  return 0;
+}
+
+// Property columns of the vertex element that end up in MeshVertex, -1 if
+// absent.
+struct PlyVertexLayout {
+  int pos[3];
+  int tex[2];
+  int normal[3];
+
+  explicit PlyVertexLayout(const PlyElement& e) {
+    static const char* const kX[] = {"x", nullptr};
+    static const char* const kY[] = {"y", nullptr};
+    static const char* const kZ[] = {"z", nullptr};
+    static const char* const kU[] = {"u", "s", "texture_u", "texture_s",
+                                     nullptr};
+    static const char* const kV[] = {"v", "t", "texture_v", "texture_t",
+                                     nullptr};
+    static const char* const kNx[] = {"nx", nullptr};
+    static const char* const kNy[] = {"ny", nullptr};
+    static const char* const kNz[] = {"nz", nullptr};
+    pos[0] = e.Find(kX);
+    pos[1] = e.Find(kY);
+    pos[2] = e.Find(kZ);
+    tex[0] = e.Find(kU);
+    tex[1] = e.Find(kV);
+    normal[0] = e.Find(kNx);
+    normal[1] = e.Find(kNy);
+    normal[2] = e.Find(kNz);
+  }
+
+  bool has_pos() const { return pos[0] >= 0 && pos[1] >= 0 && pos[2] >= 0; }
+  bool has_tex() const { return tex[0] >= 0 && tex[1] >= 0; }
+  bool has_normal() const {
+    return normal[0] >= 0 && normal[1] >= 0 && normal[2] >= 0;
+  }
+
+  void Fill(const double* values, MeshVertex& v) const {
+    v.pos = Vector3f(static_cast<float>(values[pos[0]]),
+                     static_cast<float>(values[pos[1]]),
+                     static_cast<float>(values[pos[2]]));
+    v.tex = has_tex() ? Vector2f(static_cast<float>(values[tex[0]]),
+                                 static_cast<float>(values[tex[1]]))
+                      : Vector2f(0.0f, 0.0f);
+    v.normal = has_normal()
+                   ? Vector3f(static_cast<float>(values[normal[0]]),
+                              static_cast<float>(values[normal[1]]),
+                              static_cast<float>(values[normal[2]]))
+                   : Vector3f(0.0f);
+  }
+};
+
+static bool IsFaceList(const PlyProperty& p) {
+  return p.is_list &&
+         (p.name == "vertex_indices" || p.name == "vertex_index") &&
+         p.type < kPlyFloat32;
+}
+
+// Appends the fan triangulation of one polygon, checking the indices.
+static bool AddPlyPolygon(const u32* polygon, size_t n, u64 vertex_count,
+                          std::vector<u32>& indices) {
+  for (size_t i = 0; i < n; i++) {
+    if (polygon[i] >= vertex_count) return false;
+  }
+  for (size_t i = 2; i < n; i++) {
+    indices.push_back(polygon[0]);
+    indices.push_back(polygon[i - 1]);
+    indices.push_back(polygon[i]);
+  }
+  return true;
+}
+
+// Binary body. Fixed-size vertex rows are decoded in parallel; the face
+// list is walked in one pass since rows have different lengths.
+static bool ParsePlyBinary(const char* p, const char* end, bool swap,
+                           const std::vector<PlyElement>& elements,
+                           unsigned thread_count, MeshData& mesh) {
+  std::vector<u32> polygon;
+  for (const PlyElement& e : elements) {
+    const size_t row_size = e.FixedSize();
+    if (e.name == "vertex") {
+      const PlyVertexLayout layout(e);
+      if (row_size == 0 || static_cast<u64>(end - p) / row_size < e.count) {
+        return false;
+      }
+      std::vector<size_t> offsets;
+      size_t offset = 0;
+      for (const PlyProperty& prop : e.properties) {
+        offsets.push_back(offset);
+        offset += kPlyTypeSize[prop.type];
+      }
+
+      mesh.vertices.resize(e.count);
+      const char* rows = p;
+      const size_t block = 65536;
+      ParallelFor((e.count + block - 1) / block, thread_count, [&](size_t b) {
+        std::vector<double> values(e.properties.size());
+        const size_t last = std::min<size_t>(e.count, (b + 1) * block);
+        for (size_t i = b * block; i < last; i++) {
+          const char* row = rows + i * row_size;
+          for (size_t k = 0; k < values.size(); k++) {
+            values[k] =
+                ReadPlyValue(row + offsets[k], e.properties[k].type, swap);
+          }
+          layout.Fill(values.data(), mesh.vertices[i]);
+        }
+      });
+      p += e.count * row_size;
+    } else if (e.name == "face" || row_size == 0) {
+      const bool is_face = e.name == "face";
+      for (u64 row = 0; row < e.count; row++) {
+        for (const PlyProperty& prop : e.properties) {
+          if (!prop.is_list) {
+            if (static_cast<size_t>(end - p) < kPlyTypeSize[prop.type]) {
+              return false;
+            }
+            p += kPlyTypeSize[prop.type];
+            continue;
+          }
+          if (static_cast<size_t>(end - p) < kPlyTypeSize[prop.count_type]) {
+            return false;
+          }
+          const double n = ReadPlyValue(p, prop.count_type, swap);
+          p += kPlyTypeSize[prop.count_type];
+          const size_t item_size = kPlyTypeSize[prop.type];
+          if (n < 0 || n > static_cast<double>(end - p) / item_size) {
+            return false;
+          }
+          const size_t count = static_cast<size_t>(n);
+          if (is_face && IsFaceList(prop)) {
+            polygon.resize(count);
+            for (size_t i = 0; i < count; i++) {
+              const double index = ReadPlyValue(p + i * item_size,
+                                                prop.type, swap);
+              polygon[i] = index < 0 ? kNone : static_cast<u32>(index);
+            }
+            if (!AddPlyPolygon(polygon.data(), count, mesh.vertices.size(),
+                               mesh.indices)) {
+              return false;
+            }
+          }
+          p += count * item_size;
+        }
+      }
+    } else {
+      if (static_cast<u64>(end - p) / row_size < e.count) return false;
+      p += e.count * row_size;
+    }
+  }
+  return true;
+}
+
+// ASCII body: one row per line. The rows are located in one quick newline
+// scan, then parsed in parallel blocks of kRowsPerBlock rows.
+static bool ParsePlyAscii(const char* p, const char* end,
+                          const std::vector<PlyElement>& elements,
+                          unsigned thread_count, MeshData& mesh) {
+  for (const PlyElement& e : elements) {
+    // Start of every kRowsPerBlock-th row, plus the end of the element.
+    std::vector<const char*> blocks;
+    for (u64 row = 0; row < e.count; row++) {
+      if (p >= end) return false;
+      if (row % kRowsPerBlock == 0) blocks.push_back(p);
+      p = std::min(LineEnd(p, end) + 1, end);
+    }
+    blocks.push_back(p);
+    const size_t block_count = blocks.size() - 1;
+
+    // Parses one row into |values| (list items are skipped, except for
+    // face indices which go to |polygon|).
+    auto parse_row = [&e](const char* q, const char* line_end,
+                          std::vector<double>& values,
+                          std::vector<u32>& polygon) {
+      for (size_t k = 0; k < e.properties.size(); k++) {
+        const PlyProperty& prop = e.properties[k];
+        double v;
+        if (!(q = ParseNumber(q, line_end, &v))) return false;
+        values[k] = v;
+        if (!prop.is_list) continue;
+        if (v < 0 || v > static_cast<double>(line_end - q)) return false;
+        const size_t count = static_cast<size_t>(v);
+        const bool face_list = IsFaceList(prop);
+        if (face_list) polygon.resize(count);
+        for (size_t i = 0; i < count; i++) {
+          if (!(q = ParseNumber(q, line_end, &v))) return false;
+          if (face_list) polygon[i] = v < 0 ? kNone : static_cast<u32>(v);
+        }
+      }
+      return true;
+    };
+
+    std::atomic<bool> ok(true);
+    if (e.name == "vertex") {
+      const PlyVertexLayout layout(e);
+      mesh.vertices.resize(e.count);
+      ParallelFor(block_count, thread_count, [&](size_t b) {
+        std::vector<double> values(e.properties.size());
+        std::vector<u32> polygon;
+        const char* q = blocks[b];
+        const size_t last = std::min<size_t>(e.count, (b + 1) * kRowsPerBlock);
+        for (size_t i = b * kRowsPerBlock; i < last; i++) {
+          const char* line_end = LineEnd(q, blocks[b + 1]);
+          if (!parse_row(q, line_end, values, polygon)) {
+            ok = false;
+            return;
+          }
+          layout.Fill(values.data(), mesh.vertices[i]);
+          q = line_end + 1;
+        }
+      });
+    } else if (e.name == "face") {
+      std::vector<std::vector<u32>> block_indices(block_count);
+      const u64 vertex_count = mesh.vertices.size();
+      ParallelFor(block_count, thread_count, [&](size_t b) {
+        std::vector<double> values(e.properties.size());
+        std::vector<u32> polygon;
+        const char* q = blocks[b];
+        while (q < blocks[b + 1]) {
+          const char* line_end = LineEnd(q, blocks[b + 1]);
+          polygon.clear();
+          if (!parse_row(q, line_end, values, polygon) ||
+              !AddPlyPolygon(polygon.data(), polygon.size(), vertex_count,
+                             block_indices[b])) {
+            ok = false;
+            return;
+          }
+          q = line_end + 1;
+        }
+      });
+      size_t total = 0;
+      for (const std::vector<u32>& b : block_indices) total += b.size();
+      mesh.indices.reserve(total);
+      for (const std::vector<u32>& b : block_indices) {
+        mesh.indices.insert(mesh.indices.end(), b.begin(), b.end());
+      }
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
+
+bool LoadPly(const char* fileName, MeshData& mesh, unsigned thread_count) {
+  OGLDEV_PROFILE_FUNCTION();
+  mesh = MeshData();
+  thread_count = ThreadCount(thread_count);
+
+  MappedFile file;
+  if (!file.Open(fileName, MappedFile::kAccessSequential)) {
+    return false;
+  }
+
+  PlyFormat format = kPlyAscii;
+  std::vector<PlyElement> elements;
+  const size_t body = ParsePlyHeader(file.data(), file.size(), &format,
+                                     elements);
+  const PlyElement* vertex = nullptr;
+  for (const PlyElement& e : elements) {
+    if (e.name == "vertex") vertex = &e;
+  }
+  if (body == 0 || !vertex || !PlyVertexLayout(*vertex).has_pos() ||
+      vertex->count >= kNone) {
+    OGLDEV_ERROR("'%s' is not a valid PLY mesh\n", fileName);
+    return false;
+  }
+
+  const char* begin = file.data() + body;
+  const char* end = file.data() + file.size();
+  const bool ok =
+      format == kPlyAscii
+          ? ParsePlyAscii(begin, end, elements, thread_count, mesh)
+          : ParsePlyBinary(begin, end, format == kPlyBinaryBigEndian,
+                           elements, thread_count, mesh);
+  if (!ok || mesh.indices.size() >= kNone) {
+    OGLDEV_ERROR("'%s': truncated or malformed PLY data\n", fileName);
+    mesh = MeshData();
+    return false;
+  }
+
+  const PlyVertexLayout layout(*vertex);
+  mesh.has_tex_coords = layout.has_tex();
+  mesh.has_normals = layout.has_normal();
+  if (!mesh.has_normals) {
+    std::vector<Vector3f> positions(mesh.vertices.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+      positions[i] = mesh.vertices[i].pos;
+    }
+    std::vector<Vector3f> normals;
+    SmoothNormals(positions.data(), positions.size(), mesh.indices.size(),
+                  [&mesh](size_t i) { return mesh.indices[i]; }, normals);
+    for (size_t i = 0; i < normals.size(); i++) {
+      mesh.vertices[i].normal = normals[i];
+    }
+  }
+  return true;
+}
+
+bool LoadMesh(const char* fileName, MeshData& mesh, unsigned thread_count) {
+  const char* dot = strrchr(fileName, '.');
+  std::string ext = dot ? dot + 1 : "";
+  for (char& c : ext) c = static_cast<char>(tolower(c));
+
+  if (ext == "obj") return LoadObj(fileName, mesh, thread_count);
+  if (ext == "ply") return LoadPly(fileName, mesh, thread_count);
+
+  mesh = MeshData();
+  OGLDEV_ERROR("'%s': unsupported mesh format\n", fileName);
+  return false;
+}
@@ -0,0 +1,48 @@
+#ifndef OGLDEV_MESH_LOADER_H
+#define OGLDEV_MESH_LOADER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Interleaved vertex, 32 bytes, ready for glBufferData. The attribute
+// offsets are offsetof(MeshVertex, pos), ... with stride sizeof(MeshVertex).
+struct MeshVertex {
+  Vector3f pos;
+  Vector2f tex;
+  Vector3f normal;
+};
+
+// Indexed triangle list.
+struct MeshData {
+  std::vector<MeshVertex> vertices;
+  std::vector<u32> indices;
+  // False if the file had none; tex is then zero and normal is the
+  // area-weighted smooth normal computed from the triangles.
+  bool has_tex_coords;
+  bool has_normals;
+
+  MeshData() : has_tex_coords(false), has_normals(false) {}
+};
+
+// In-tree loaders for Wavefront OBJ and PLY (ASCII and binary), as an
+// alternative to assimp for large files.
+//
+// The file is mapped, split into line-aligned chunks and parsed on
+// |thread_count| threads (0: one per hardware thread) with a locale-free
+// float parser. Polygons are triangulated as fans. OBJ corners that
+// reference the same position/texture/normal triple become one vertex,
+// like aiProcess_JoinIdenticalVertices does for OBJ files exported with
+// shared indices; vertices keep the order of first use. Materials, groups
+// and other OBJ/PLY elements are ignored.
+//
+// Errors are reported with OGLDEV_ERROR; |mesh| is left empty on failure.
+bool LoadObj(const char* fileName, MeshData& mesh, unsigned thread_count = 0);
+bool LoadPly(const char* fileName, MeshData& mesh, unsigned thread_count = 0);
+
+// Dispatches on the extension (.obj or .ply, any case).
+bool LoadMesh(const char* fileName, MeshData& mesh, unsigned thread_count = 0);
+
+#endif  // OGLDEV_MESH_LOADER_H
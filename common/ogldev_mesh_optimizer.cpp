@@ -0,0 +1,254 @@
+#include "ogldev_mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Forsyth's modeled LRU cache and score tables ("Linear-Speed Vertex Cache
+// Optimisation", 2006). The cache is larger than the real FIFO so that
+// orders stay good for any hardware cache size up to it.
+static const int kCacheSize = 32;
+static const int kMaxValence = 32;
+static const float kLastTriangleScore = 0.75f;
+static const float kCacheDecayPower = 1.5f;
+static const float kValenceBoostScale = 2.0f;
+static const float kValenceBoostPower = 0.5f;
+
+VertexCacheStats AnalyzeVertexCache(const u32* indices, size_t index_count,
+                                    size_t vertex_count, u32 cache_size) {
+  // A vertex is in the FIFO if it was transformed less than |cache_size|
+  // transforms ago.
+  std::vector<u64> transformed_at(vertex_count, 0);
+  u64 transformed = 0;
+  for (size_t i = 0; i < index_count; i++) {
+    u64& at = transformed_at[indices[i]];
+    if (at == 0 || transformed + 1 - at > cache_size) {
+      transformed++;
+      at = transformed;
+    }
+  }
+
+  VertexCacheStats stats;
+  stats.transformed = transformed;
+  stats.acmr = index_count ? transformed / (index_count / 3.0f) : 0.0f;
+  stats.atvr = vertex_count ? static_cast<float>(transformed) / vertex_count
+                            : 0.0f;
+  return stats;
+}
+
+static u64 HashBytes(const u8* p, size_t size) {
+  u64 h = 14695981039346656037ull;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    u32 word;
+    memcpy(&word, p + i, 4);
+    h = (h ^ word) * 1099511628211ull;
+  }
+  for (; i < size; i++) {
+    h = (h ^ p[i]) * 1099511628211ull;
+  }
+  return h ^ (h >> 29);
+}
+
+size_t WeldVertices(const void* vertices, size_t vertex_count,
+                    size_t vertex_size, u32* remap) {
+  const u8* bytes = static_cast<const u8*>(vertices);
+
+  // Open addressing at most half full, holding the first vertex of each
+  // class.
+  size_t table_size = 16;
+  while (table_size < vertex_count * 2) table_size *= 2;
+  std::vector<u32> table(table_size, kNoVertex);
+  const size_t mask = table_size - 1;
+
+  u32 unique = 0;
+  for (size_t i = 0; i < vertex_count; i++) {
+    const u8* v = bytes + i * vertex_size;
+    size_t slot = HashBytes(v, vertex_size) & mask;
+    for (;;) {
+      const u32 first = table[slot];
+      if (first == kNoVertex) {
+        table[slot] = static_cast<u32>(i);
+        remap[i] = unique++;
+        break;
+      }
+      if (memcmp(bytes + first * vertex_size, v, vertex_size) == 0) {
+        remap[i] = remap[first];
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+  }
+  return unique;
+}
+
+void RemapVertices(const void* in, size_t vertex_count, size_t vertex_size,
+                   const u32* remap, void* out) {
+  const u8* src = static_cast<const u8*>(in);
+  u8* dst = static_cast<u8*>(out);
+  for (size_t i = 0; i < vertex_count; i++) {
+    memcpy(dst + remap[i] * vertex_size, src + i * vertex_size, vertex_size);
+  }
+}
+
+namespace {
+
+struct ScoreTables {
+  float cache[kCacheSize];
+  float valence[kMaxValence + 1];
+
+  ScoreTables() {
+    for (int i = 0; i < kCacheSize; i++) {
+      if (i < 3) {
+        // The triangle just emitted: its edges are the likeliest to be
+        // shared next, but not preferred over the rest of the cache, or
+        // strips would form instead of fans.
+        cache[i] = kLastTriangleScore;
+      } else {
+        const float scale = 1.0f / (kCacheSize - 3);
+        cache[i] = powf(1.0f - (i - 3) * scale, kCacheDecayPower);
+      }
+    }
+    valence[0] = 0.0f;
+    for (int i = 1; i <= kMaxValence; i++) {
+      // Finishing off vertices with few triangles left avoids leaving
+      // lone triangles behind that would need the vertex again later.
+      valence[i] = kValenceBoostScale * powf(i, -kValenceBoostPower);
+    }
+  }
+
+  float Score(int cache_position, u32 live_triangles) const {
+    if (live_triangles == 0) return -1.0f;
+    const float c = cache_position >= 0 ? cache[cache_position] : 0.0f;
+    return c + valence[std::min<u32>(live_triangles, kMaxValence)];
+  }
+};
+
+}  // namespace
+
+void OptimizeVertexCache(u32* indices, size_t index_count,
+                         size_t vertex_count) {
+  static const ScoreTables tables;
+  const size_t triangle_count = index_count / 3;
+  if (triangle_count == 0) {
+    return;
+  }
+
+  // Triangles around each vertex; the first live_[v] entries of a
+  // vertex's range are the triangles not emitted yet.
+  std::vector<u32> live(vertex_count, 0);
+  for (size_t i = 0; i < triangle_count * 3; i++) live[indices[i]]++;
+  std::vector<u32> offsets(vertex_count + 1, 0);
+  for (size_t v = 0; v < vertex_count; v++) {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+  std::vector<u32> adjacency(triangle_count * 3);
+  {
+    std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+      adjacency[fill[indices[i]]++] = static_cast<u32>(i / 3);
+    }
+  }
+
+  std::vector<float> vertex_score(vertex_count);
+  std::vector<int> cache_position(vertex_count, -1);
+  for (size_t v = 0; v < vertex_count; v++) {
+    vertex_score[v] = tables.Score(-1, live[v]);
+  }
+  std::vector<float> triangle_score(triangle_count);
+  for (size_t t = 0; t < triangle_count; t++) {
+    const u32* tri = indices + t * 3;
+    triangle_score[t] =
+        vertex_score[tri[0]] + vertex_score[tri[1]] + vertex_score[tri[2]];
+  }
+
+  std::vector<u8> emitted(triangle_count, 0);
+  std::vector<u32> out(triangle_count * 3);
+  u32 cache[kCacheSize + 3];
+  u32 new_cache[kCacheSize + 3];
+  int cache_count = 0;
+  size_t cursor = 0;
+
+  u32 best = 0;
+  for (size_t t = 1; t < triangle_count; t++) {
+    if (triangle_score[t] > triangle_score[best]) best = static_cast<u32>(t);
+  }
+
+  for (size_t emitted_count = 0; emitted_count < triangle_count;
+       emitted_count++) {
+    const u32* tri = indices + best * 3;
+    memcpy(&out[emitted_count * 3], tri, 3 * sizeof(u32));
+    emitted[best] = 1;
+
+    // Retire the triangle from its vertices' live lists.
+    for (int k = 0; k < 3; k++) {
+      const u32 v = tri[k];
+      u32* list = &adjacency[offsets[v]];
+      u32* end = list + live[v];
+      *std::find(list, end, best) = end[-1];
+      live[v]--;
+    }
+
+    // The triangle's vertices move to the front of the cache; the vertices
+    // pushed past kCacheSize stay in new_cache so their scores drop too.
+    int new_count = 0;
+    for (int k = 0; k < 3; k++) new_cache[new_count++] = tri[k];
+    for (int i = 0; i < cache_count; i++) {
+      const u32 v = cache[i];
+      if (v != tri[0] && v != tri[1] && v != tri[2]) {
+        new_cache[new_count++] = v;
+      }
+    }
+
+    for (int i = 0; i < new_count; i++) {
+      const u32 v = new_cache[i];
+      cache_position[v] = i < kCacheSize ? i : -1;
+      const float score = tables.Score(cache_position[v], live[v]);
+      const float delta = score - vertex_score[v];
+      vertex_score[v] = score;
+      const u32* list = &adjacency[offsets[v]];
+      for (u32 j = 0; j < live[v]; j++) triangle_score[list[j]] += delta;
+    }
+    cache_count = std::min(new_count, kCacheSize);
+    memcpy(cache, new_cache, cache_count * sizeof(u32));
+
+    // Next: the best triangle around the cache, or the next triangle in
+    // input order if the cache has no live triangles left.
+    float best_score = -1.0f;
+    for (int i = 0; i < cache_count; i++) {
+      const u32 v = cache[i];
+      const u32* list = &adjacency[offsets[v]];
+      for (u32 j = 0; j < live[v]; j++) {
+        if (triangle_score[list[j]] > best_score) {
+          best_score = triangle_score[list[j]];
+          best = list[j];
+        }
+      }
+    }
+    if (best_score < 0.0f) {
+      while (cursor < triangle_count && emitted[cursor]) cursor++;
+      best = static_cast<u32>(cursor);
+    }
+  }
+
+  memcpy(indices, out.data(), out.size() * sizeof(u32));
+}
+
+size_t OptimizeVertexFetchRemap(u32* indices, size_t index_count,
+                                size_t vertex_count, u32* remap) {
+  std::fill(remap, remap + vertex_count, kNoVertex);
+  u32 next = 0;
+  for (size_t i = 0; i < index_count; i++) {
+    u32& r = remap[indices[i]];
+    if (r == kNoVertex) r = next++;
+    indices[i] = r;
+  }
+  return next;
+}
+
+void OptimizeMesh(MeshData& mesh) {
+  OptimizeVertexCache(mesh.indices.data(), mesh.indices.size(),
+                      mesh.vertices.size());
+  OptimizeVertexFetch(mesh.indices.data(), mesh.indices.size(),
+                      mesh.vertices);
+}
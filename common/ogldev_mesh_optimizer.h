@@ -0,0 +1,94 @@
+#ifndef OGLDEV_MESH_OPTIMIZER_H
+#define OGLDEV_MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_mesh_loader.h"
+#include "ogldev_types.h"
+
+// Index buffer generation and reordering for the vertex stage.
+//
+// Drawing an unindexed triangle list transforms every corner, three
+// vertices per triangle. With an index buffer the GPU keeps recently
+// transformed vertices in a small post-transform cache, so how often a
+// vertex is transformed depends on the triangle order. The usual pipeline:
+//
+//   std::vector<Vertex> vertices;
+//   std::vector<u32> indices;
+//   GenerateIndexBuffer(triangles, corner_count, vertices, indices);
+//   OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+//   OptimizeVertexFetch(indices.data(), indices.size(), vertices);
+//
+// Vertices are compared byte by byte, so vertex structs must not have
+// padding, and -0.0f and 0.0f are different.
+
+constexpr u32 kNoVertex = 0xffffffff;
+
+// Average cache miss ratio (vertices transformed per triangle; 3 for no
+// reuse, about 0.5 for a perfect order on a large regular grid) and
+// average transform to vertex ratio (vertices transformed per vertex;
+// 1 is ideal), for a FIFO post-transform cache of |cache_size| entries.
+struct VertexCacheStats {
+  u64 transformed;
+  float acmr;
+  float atvr;
+};
+
+VertexCacheStats AnalyzeVertexCache(const u32* indices, size_t index_count,
+                                    size_t vertex_count,
+                                    u32 cache_size = 16);
+
+// Joins bitwise identical vertices: remap[i] is the new index of vertex
+// i, with new indices given in order of first occurrence. Returns the
+// number of unique vertices.
+size_t WeldVertices(const void* vertices, size_t vertex_count,
+                    size_t vertex_size, u32* remap);
+
+// out[remap[i]] = in[i]. |out| holds the unique vertex count.
+void RemapVertices(const void* in, size_t vertex_count, size_t vertex_size,
+                   const u32* remap, void* out);
+
+// Reorders the triangles of an index buffer for the post-transform cache
+// with Tom Forsyth's linear-speed algorithm: vertices score by their
+// position in a modeled LRU cache and by how few triangles still use them,
+// and the best scoring triangle around the cache is emitted next. In
+// place; the triangles themselves are unchanged.
+void OptimizeVertexCache(u32* indices, size_t index_count,
+                         size_t vertex_count);
+
+// Renumbers vertices in the order the index buffer first uses them, so
+// vertex fetches walk memory forward, and drops unreferenced vertices.
+// |remap| receives the new index of each vertex (kNoVertex if dropped).
+// Returns the number of vertices kept.
+size_t OptimizeVertexFetchRemap(u32* indices, size_t index_count,
+                                size_t vertex_count, u32* remap);
+
+template <typename Vertex>
+void GenerateIndexBuffer(const Vertex* corners, size_t corner_count,
+                         std::vector<Vertex>& vertices,
+                         std::vector<u32>& indices) {
+  indices.resize(corner_count);
+  const size_t unique =
+      WeldVertices(corners, corner_count, sizeof(Vertex), indices.data());
+  vertices.resize(unique);
+  RemapVertices(corners, corner_count, sizeof(Vertex), indices.data(),
+                vertices.data());
+}
+
+template <typename Vertex>
+void OptimizeVertexFetch(u32* indices, size_t index_count,
+                         std::vector<Vertex>& vertices) {
+  std::vector<u32> remap(vertices.size());
+  std::vector<Vertex> reordered(OptimizeVertexFetchRemap(
+      indices, index_count, vertices.size(), remap.data()));
+  for (size_t i = 0; i < vertices.size(); i++) {
+    if (remap[i] != kNoVertex) reordered[remap[i]] = vertices[i];
+  }
+  vertices.swap(reordered);
+}
+
+// Cache then fetch optimization of a loaded mesh.
+void OptimizeMesh(MeshData& mesh);
+
+#endif  // OGLDEV_MESH_OPTIMIZER_H
@@ -0,0 +1,244 @@
+#include "ogldev_profiler.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Zones are stored in blocks of this many, allocated as a thread needs
+// them, so that recording never moves the zones already written.
+static const size_t kBlockZones = 4096;
+// At 24 bytes per zone, a thread stops recording after 96MB, until the next
+// ProfilerClear(). Blocks are kept for reuse once allocated.
+static const size_t kMaxBlocks = 1024;
+
+std::atomic<bool> g_ogldev_profiler_active(false);
+
+namespace {
+
+struct Zone {
+  const char* name;
+  u64 begin_ns;
+  u64 end_ns;
+};
+
+// The zones of one thread. The thread appends and publishes the new count;
+// the exporter reads up to the published count from any thread.
+//
+// ProfilerClear() cannot reset the count itself without racing the thread,
+// so it only bumps clear_epoch_. The thread notices on its next zone and
+// starts over at the first block, reusing the memory. The count is
+// published together with the epoch it belongs to, and the exporter, which
+// holds the registry mutex that ProfilerClear() needs, ignores counts from
+// an older epoch. So it never reads a zone that is being overwritten.
+class ThreadProfile {
+ public:
+  explicit ThreadProfile(u32 id)
+      : id_(id), clear_epoch_(0), published_(0), dropped_(0) {}
+
+  void Record(const char* name, u64 begin_ns, u64 end_ns) {
+    // Acquire, so that the exporter's reads before the clear happen before
+    // the zones are overwritten.
+    const u32 epoch = clear_epoch_.load(std::memory_order_acquire);
+    const u64 published = published_.load(std::memory_order_relaxed);
+    size_t n = Count(published);
+    if (Epoch(published) != epoch) {
+      n = 0;
+      dropped_.store(0, std::memory_order_relaxed);
+    }
+    const size_t block = n / kBlockZones;
+    if (block >= kMaxBlocks) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+      return;
+    }
+    if (!blocks_[block]) {
+      blocks_[block].reset(new Zone[kBlockZones]);
+    }
+    Zone& zone = blocks_[block][n % kBlockZones];
+    zone.name = name;
+    zone.begin_ns = begin_ns;
+    zone.end_ns = end_ns;
+    published_.store(Publish(epoch, n + 1), std::memory_order_release);
+  }
+
+  // The rest is used under the registry mutex.
+
+  // Zones recorded and dropped since the last ProfilerClear().
+  size_t count() const {
+    const u64 published = published_.load(std::memory_order_acquire);
+    return Current(published) ? Count(published) : 0;
+  }
+  u64 dropped() const {
+    return Current(published_.load(std::memory_order_relaxed))
+               ? dropped_.load(std::memory_order_relaxed)
+               : 0;
+  }
+  const Zone& zone(size_t i) const {
+    return blocks_[i / kBlockZones][i % kBlockZones];
+  }
+  void Clear() { clear_epoch_.fetch_add(1, std::memory_order_release); }
+
+  u32 id() const { return id_; }
+  const std::string& name() const { return name_; }
+  void set_name(const char* name) { name_ = name; }
+
+ private:
+  static u64 Publish(u32 epoch, size_t count) {
+    return static_cast<u64>(epoch) << 32 | count;
+  }
+  static u32 Epoch(u64 published) { return static_cast<u32>(published >> 32); }
+  static size_t Count(u64 published) {
+    return static_cast<u32>(published);
+  }
+  bool Current(u64 published) const {
+    return Epoch(published) == clear_epoch_.load(std::memory_order_relaxed);
+  }
+
+  u32 id_;
+  std::string name_;
+  std::atomic<u32> clear_epoch_;
+  // Epoch in the high 32 bits, count in the low 32.
+  std::atomic<u64> published_;
+  std::atomic<u64> dropped_;
+  std::unique_ptr<Zone[]> blocks_[kMaxBlocks];
+};
+
+// Every thread that has recorded a zone or been named. Profiles are never
+// freed, so the zones of exited threads can still be exported.
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadProfile*> profiles;
+};
+
+Registry& GetRegistry() {
+  // Leaked: threads may record while static destructors run.
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+thread_local ThreadProfile* t_profile = nullptr;
+
+ThreadProfile& GetThreadProfile() {
+  if (!t_profile) {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    t_profile =
+        new ThreadProfile(static_cast<u32>(registry.profiles.size() + 1));
+    registry.profiles.push_back(t_profile);
+  }
+  return *t_profile;
+}
+
+// Writes |s| as the contents of a JSON string.
+void WriteJsonString(FILE* f, const char* s) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+  while (*p >= 0x20 && *p != '"' && *p != '\\') p++;
+  if (!*p) {
+    fputs(s, f);  // The common case: nothing to escape.
+    return;
+  }
+  for (; *s; s++) {
+    const unsigned char c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+      fputc(c, f);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc(c, f);
+    }
+  }
+}
+
+}  // namespace
+
+void ProfilerStart() {
+  g_ogldev_profiler_active.store(true, std::memory_order_relaxed);
+}
+
+void ProfilerStop() {
+  g_ogldev_profiler_active.store(false, std::memory_order_relaxed);
+}
+
+void ProfilerClear() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (ThreadProfile* profile : registry.profiles) {
+    profile->Clear();
+  }
+}
+
+void ProfilerSetThreadName(const char* name) {
+  ThreadProfile& profile = GetThreadProfile();
+  std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+  profile.set_name(name);
+}
+
+void RecordProfileZone(const char* name, u64 begin_ns, u64 end_ns) {
+  GetThreadProfile().Record(name, begin_ns, end_ns);
+}
+
+bool WriteChromeTrace(const char* fileName) {
+  FILE* f = fopen(fileName, "wb");
+  if (!f) {
+    OGLDEV_FILE_ERROR(fileName);
+    return false;
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 16);
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  // Snapshot the counts, so that both passes see the same zones.
+  std::vector<size_t> counts(registry.profiles.size());
+  u64 origin_ns = ~0ull;
+  u64 dropped = 0;
+  for (size_t t = 0; t < registry.profiles.size(); t++) {
+    const ThreadProfile& profile = *registry.profiles[t];
+    counts[t] = profile.count();
+    for (size_t i = 0; i < counts[t]; i++) {
+      origin_ns = std::min(origin_ns, profile.zone(i).begin_ns);
+    }
+    dropped += profile.dropped();
+  }
+
+  // Timestamps are in microseconds, relative to the earliest zone.
+  fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+  bool first = true;
+  for (size_t t = 0; t < registry.profiles.size(); t++) {
+    const ThreadProfile& profile = *registry.profiles[t];
+    if (!profile.name().empty()) {
+      fprintf(f,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%u,\"args\":{\"name\":\"",
+              first ? "" : ",", profile.id());
+      WriteJsonString(f, profile.name().c_str());
+      fputs("\"}}", f);
+      first = false;
+    }
+    for (size_t i = 0; i < counts[t]; i++) {
+      const Zone& zone = profile.zone(i);
+      fprintf(f, "%s\n{\"name\":\"", first ? "" : ",");
+      WriteJsonString(f, zone.name);
+      fprintf(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                 "\"dur\":%.3f}",
+              profile.id(), (zone.begin_ns - origin_ns) / 1000.0,
+              (zone.end_ns - zone.begin_ns) / 1000.0);
+      first = false;
+    }
+  }
+  fputs("\n]}\n", f);
+
+  const bool ok = !ferror(f);
+  if (fclose(f) != 0 || !ok) {
+    OGLDEV_ERROR("Error writing '%s'\n", fileName);
+    return false;
+  }
+  if (dropped > 0) {
+    OGLDEV_LOG(kLogWarning, "%llu profile zones were dropped\n",
+               static_cast<unsigned long long>(dropped));
+  }
+  return true;
+}
@@ -0,0 +1,97 @@
+#ifndef OGLDEV_PROFILER_H
+#define OGLDEV_PROFILER_H
+
+#include <atomic>
+
+#include "ogldev_types.h"
+#include "ogldev_util.h"
+
+// Scoped CPU profiling zones, exported as Chrome trace events:
+//
+//   static void RenderSceneCB() {
+//     OGLDEV_PROFILE_FUNCTION();
+//     ...
+//     {
+//       OGLDEV_PROFILE_SCOPE("Draw");
+//       ...
+//     }
+//   }
+//
+//   ProfilerStart();
+//   ...
+//   WriteChromeTrace("trace.json");  // Open in chrome://tracing or Perfetto.
+//
+// A zone stores its name pointer and its begin and end times in a buffer
+// owned by the calling thread, so threads never contend and nothing is
+// formatted until the export. Zones are free apart from a flag check until
+// ProfilerStart(); after it each one costs two GetTimeNs() calls and a
+// store. Names must outlive the export, which literals and __func__ do.
+//
+// Defining OGLDEV_NO_PROFILER (the CMake option of the same name) compiles
+// the zones out; the functions below remain and export an empty trace.
+
+// Zones record only between ProfilerStart() and ProfilerStop(). A zone
+// that is open when recording starts is not recorded; one that is open when
+// it stops still is.
+void ProfilerStart();
+void ProfilerStop();
+
+// Discards everything recorded so far. Each thread can hold about four
+// million zones between clears; later ones are dropped and counted. A
+// thread's buffer is kept and refilled from the start after a clear.
+void ProfilerClear();
+
+// Labels the calling thread's track in the trace.
+void ProfilerSetThreadName(const char* name);
+
+// Writes the recorded zones of all threads, including threads that have
+// exited, in the Chrome trace-event JSON format. Zones still being recorded
+// by other threads may or may not be included.
+bool WriteChromeTrace(const char* fileName);
+
+extern std::atomic<bool> g_ogldev_profiler_active;
+
+inline bool ProfilerActive() {
+  return g_ogldev_profiler_active.load(std::memory_order_relaxed);
+}
+
+// Adds a zone that took place between |begin_ns| and |end_ns| (GetTimeNs()
+// values) to the calling thread's buffer.
+void RecordProfileZone(const char* name, u64 begin_ns, u64 end_ns);
+
+class ProfileZone {
+ public:
+  explicit ProfileZone(const char* name)
+      : name_(name), active_(ProfilerActive()),
+        begin_ns_(active_ ? GetTimeNs() : 0) {}
+
+  ~ProfileZone() {
+    if (active_) {
+      RecordProfileZone(name_, begin_ns_, GetTimeNs());
+    }
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+ private:
+  const char* name_;
+  bool active_;
+  u64 begin_ns_;
+};
+
+#define OGLDEV_PROFILE_CONCAT2(a, b) a##b
+#define OGLDEV_PROFILE_CONCAT(a, b) OGLDEV_PROFILE_CONCAT2(a, b)
+
+#ifndef OGLDEV_NO_PROFILER
+// |name| must be a string literal.
+#define OGLDEV_PROFILE_SCOPE(name) \
+    ProfileZone OGLDEV_PROFILE_CONCAT(ogldev_zone_, __COUNTER__)("" name)
+#define OGLDEV_PROFILE_FUNCTION() \
+    ProfileZone OGLDEV_PROFILE_CONCAT(ogldev_zone_, __COUNTER__)(__func__)
+#else
+#define OGLDEV_PROFILE_SCOPE(name) do {} while (0)
+#define OGLDEV_PROFILE_FUNCTION() do {} while (0)
+#endif
+
+#endif  // OGLDEV_PROFILER_H
@@ -0,0 +1,308 @@
+#include "ogldev_quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ogldev_simd.h"
+
+// Keeps the octahedral encoding of a zero vector finite.
+static const float kMinL1Norm = 1e-30f;
+
+static u32 FloatBits(float f) {
+  u32 u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float BitsToFloat(u32 u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+u16 FloatToHalf(float f) {
+  const u32 kInfinity = 255u << 23;
+  // Smallest float that overflows to infinity in half precision.
+  const u32 kHalfOverflow = (127u + 16u) << 23;
+  // Smallest float that is a normal half.
+  const u32 kHalfNormal = 113u << 23;
+  // Adding this to a denormal half value leaves its mantissa bits in the
+  // low bits of the float, rounded by the FPU.
+  const u32 kDenormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  u32 x = FloatBits(f);
+  const u32 sign = x & 0x80000000u;
+  x ^= sign;
+
+  u32 h;
+  if (x >= kHalfOverflow) {
+    h = x > kInfinity ? 0x7e00u : 0x7c00u;
+  } else if (x < kHalfNormal) {
+    h = FloatBits(BitsToFloat(x) + BitsToFloat(kDenormMagic)) - kDenormMagic;
+  } else {
+    // Rebias the exponent and round the mantissa to nearest even.
+    const u32 mantissa_odd = (x >> 13) & 1;
+    x += ((15u - 127u) << 23) + 0xfffu + mantissa_odd;
+    h = x >> 13;
+  }
+
+  return static_cast<u16>(h | (sign >> 16));
+}
+
+float HalfToFloat(u16 h) {
+  const u32 kExponentMask = 0x7c00u << 13;
+
+  u32 x = (h & 0x7fffu) << 13;
+  const u32 exponent = x & kExponentMask;
+  x += (127u - 15u) << 23;
+
+  if (exponent == kExponentMask) {
+    // Infinity or NaN.
+    x += (128u - 16u) << 23;
+  } else if (exponent == 0) {
+    // Zero or denormal: renormalize through the FPU.
+    x += 1u << 23;
+    x = FloatBits(BitsToFloat(x) - BitsToFloat(113u << 23));
+  }
+
+  return BitsToFloat(x | (static_cast<u32>(h & 0x8000u) << 16));
+}
+
+void EncodeHalf(const float* in, u16* out, size_t count) {
+  size_t i = 0;
+#if defined(OGLDEV_SIMD_HALF)
+  for (; i + 4 <= count; i += 4) {
+    simd::StoreHalf4(out + i, simd::Load4(in + i));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = FloatToHalf(in[i]);
+  }
+}
+
+void DecodeHalf(const u16* in, float* out, size_t count) {
+  size_t i = 0;
+#if defined(OGLDEV_SIMD_HALF)
+  for (; i + 4 <= count; i += 4) {
+    simd::Store4(out + i, simd::LoadHalf4(in + i));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = HalfToFloat(in[i]);
+  }
+}
+
+void EncodePositionsHalf(const Vector3f* in, u16* out, size_t count) {
+  const u16 kHalfOne = 0x3c00;
+
+  size_t i = 0;
+#if defined(OGLDEV_SIMD_HALF)
+  for (; i + 4 <= count; i += 4) {
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+    simd::Float4 w = simd::Splat4(1.0f);
+    simd::Transpose4(x, y, z, w);
+    simd::StoreHalf4(out + 4 * i, x);
+    simd::StoreHalf4(out + 4 * i + 4, y);
+    simd::StoreHalf4(out + 4 * i + 8, z);
+    simd::StoreHalf4(out + 4 * i + 12, w);
+  }
+#endif
+  for (; i < count; i++) {
+    out[4 * i + 0] = FloatToHalf(in[i].x);
+    out[4 * i + 1] = FloatToHalf(in[i].y);
+    out[4 * i + 2] = FloatToHalf(in[i].z);
+    out[4 * i + 3] = kHalfOne;
+  }
+}
+
+static i32 RoundToInt(float f) {
+  return static_cast<i32>(lrintf(f));
+}
+
+static float ClampUnit(float f) {
+  return std::min(std::max(f, -1.0f), 1.0f);
+}
+
+u32 EncodeNormal1010102(const Vector3f& n) {
+  const u32 x = static_cast<u32>(RoundToInt(ClampUnit(n.x) * 511.0f));
+  const u32 y = static_cast<u32>(RoundToInt(ClampUnit(n.y) * 511.0f));
+  const u32 z = static_cast<u32>(RoundToInt(ClampUnit(n.z) * 511.0f));
+  return (x & 0x3ff) | ((y & 0x3ff) << 10) | ((z & 0x3ff) << 20);
+}
+
+// Sign-extends the 10-bit field at |shift| and maps it back to [-1, 1] as
+// GL does for normalized signed integers.
+static float DecodeSnorm10(u32 packed, int shift) {
+  const i32 v = static_cast<i32>(packed << (22 - shift)) >> 22;
+  return std::max(v / 511.0f, -1.0f);
+}
+
+Vector3f DecodeNormal1010102(u32 packed) {
+  return Vector3f(DecodeSnorm10(packed, 0), DecodeSnorm10(packed, 10),
+                  DecodeSnorm10(packed, 20));
+}
+
+void EncodeNormals1010102(const Vector3f* in, u32* out, size_t count) {
+  const simd::Float4 lo = simd::Splat4(-1.0f);
+  const simd::Float4 hi = simd::Splat4(1.0f);
+  const simd::Float4 scale = simd::Splat4(511.0f);
+  const simd::UInt4 mask = simd::SplatU4(0x3ff);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+    x = simd::Mul4(simd::Min4(simd::Max4(x, lo), hi), scale);
+    y = simd::Mul4(simd::Min4(simd::Max4(y, lo), hi), scale);
+    z = simd::Mul4(simd::Min4(simd::Max4(z, lo), hi), scale);
+
+    const simd::UInt4 qx = simd::AndU4(simd::RoundToInt4(x), mask);
+    const simd::UInt4 qy = simd::AndU4(simd::RoundToInt4(y), mask);
+    const simd::UInt4 qz = simd::AndU4(simd::RoundToInt4(z), mask);
+    simd::StoreU4(out + i, simd::OrU4(simd::OrU4(qx, simd::ShlU4<10>(qy)),
+                                      simd::ShlU4<20>(qz)));
+  }
+  for (; i < count; i++) {
+    out[i] = EncodeNormal1010102(in[i]);
+  }
+}
+
+u32 EncodeNormalOct(const Vector3f& n) {
+  // Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower
+  // half over the upper one.
+  const float l1 = (fabsf(n.x) + fabsf(n.y)) + fabsf(n.z);
+  const float inv = 1.0f / std::max(l1, kMinL1Norm);
+  float x = n.x * inv;
+  float y = n.y * inv;
+  if (!(n.z >= 0.0f)) {
+    const float fx = 1.0f - fabsf(y);
+    const float fy = 1.0f - fabsf(x);
+    x = std::signbit(x) ? -fx : fx;
+    y = std::signbit(y) ? -fy : fy;
+  }
+
+  const u32 qx = static_cast<u32>(RoundToInt(x * 32767.0f));
+  const u32 qy = static_cast<u32>(RoundToInt(y * 32767.0f));
+  return (qx & 0xffff) | (qy << 16);
+}
+
+Vector3f DecodeNormalOct(u32 packed) {
+  const i16 qx = static_cast<i16>(packed & 0xffff);
+  const i16 qy = static_cast<i16>(packed >> 16);
+  const float x = std::max(qx / 32767.0f, -1.0f);
+  const float y = std::max(qy / 32767.0f, -1.0f);
+
+  Vector3f n(x, y, 1.0f - fabsf(x) - fabsf(y));
+  const float t = std::max(-n.z, 0.0f);
+  n.x += n.x >= 0.0f ? -t : t;
+  n.y += n.y >= 0.0f ? -t : t;
+  return n.Normalize();
+}
+
+void EncodeNormalsOct(const Vector3f* in, u32* out, size_t count) {
+  const simd::Float4 zero = simd::Splat4(0.0f);
+  const simd::Float4 one = simd::Splat4(1.0f);
+  const simd::Float4 min_norm = simd::Splat4(kMinL1Norm);
+  const simd::Float4 scale = simd::Splat4(32767.0f);
+  const simd::UInt4 mask = simd::SplatU4(0xffff);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+
+    const simd::Float4 l1 = simd::Add4(
+        simd::Add4(simd::Abs4(x), simd::Abs4(y)), simd::Abs4(z));
+    const simd::Float4 inv = simd::Div4(one, simd::Max4(l1, min_norm));
+    x = simd::Mul4(x, inv);
+    y = simd::Mul4(y, inv);
+
+    const simd::Float4 fx = simd::FlipSign4(simd::Sub4(one, simd::Abs4(y)), x);
+    const simd::Float4 fy = simd::FlipSign4(simd::Sub4(one, simd::Abs4(x)), y);
+    const simd::Mask4 upper = simd::CmpGe4(z, zero);
+    x = simd::Select4(upper, x, fx);
+    y = simd::Select4(upper, y, fy);
+
+    const simd::UInt4 qx =
+        simd::AndU4(simd::RoundToInt4(simd::Mul4(x, scale)), mask);
+    const simd::UInt4 qy = simd::RoundToInt4(simd::Mul4(y, scale));
+    simd::StoreU4(out + i, simd::OrU4(qx, simd::ShlU4<16>(qy)));
+  }
+  for (; i < count; i++) {
+    out[i] = EncodeNormalOct(in[i]);
+  }
+}
+
+// Per-axis factor from [min, max] to [0, 65535]; 0 for a flat axis.
+static float Unorm16Scale(float min, float max) {
+  return max > min ? 65535.0f / (max - min) : 0.0f;
+}
+
+static u16 EncodeUnorm16(float p, float min, float scale) {
+  const float v = std::min(std::max((p - min) * scale, 0.0f), 65535.0f);
+  return static_cast<u16>(RoundToInt(v));
+}
+
+void EncodePositionsUnorm16(const Vector3f* in, size_t count,
+                            const Vector3f& min, const Vector3f& max,
+                            u16* out) {
+  const Vector3f scale(Unorm16Scale(min.x, max.x),
+                       Unorm16Scale(min.y, max.y),
+                       Unorm16Scale(min.z, max.z));
+
+  const simd::Float4 zero = simd::Splat4(0.0f);
+  const simd::Float4 limit = simd::Splat4(65535.0f);
+  const simd::Float4 min_x = simd::Splat4(min.x);
+  const simd::Float4 min_y = simd::Splat4(min.y);
+  const simd::Float4 min_z = simd::Splat4(min.z);
+  const simd::Float4 scale_x = simd::Splat4(scale.x);
+  const simd::Float4 scale_y = simd::Splat4(scale.y);
+  const simd::Float4 scale_z = simd::Splat4(scale.z);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+    x = simd::Mul4(simd::Sub4(x, min_x), scale_x);
+    y = simd::Mul4(simd::Sub4(y, min_y), scale_y);
+    z = simd::Mul4(simd::Sub4(z, min_z), scale_z);
+
+    u32 qx[4], qy[4], qz[4];
+    simd::StoreU4(qx, simd::RoundToInt4(
+                          simd::Min4(simd::Max4(x, zero), limit)));
+    simd::StoreU4(qy, simd::RoundToInt4(
+                          simd::Min4(simd::Max4(y, zero), limit)));
+    simd::StoreU4(qz, simd::RoundToInt4(
+                          simd::Min4(simd::Max4(z, zero), limit)));
+
+    u16* o = out + 4 * i;
+    for (int k = 0; k < 4; k++) {
+      o[4 * k + 0] = static_cast<u16>(qx[k]);
+      o[4 * k + 1] = static_cast<u16>(qy[k]);
+      o[4 * k + 2] = static_cast<u16>(qz[k]);
+      o[4 * k + 3] = 0xffff;
+    }
+  }
+  for (; i < count; i++) {
+    out[4 * i + 0] = EncodeUnorm16(in[i].x, min.x, scale.x);
+    out[4 * i + 1] = EncodeUnorm16(in[i].y, min.y, scale.y);
+    out[4 * i + 2] = EncodeUnorm16(in[i].z, min.z, scale.z);
+    out[4 * i + 3] = 0xffff;
+  }
+}
+
+Vector3f DecodePositionUnorm16(const u16* p, const Vector3f& min,
+                               const Vector3f& max) {
+  const Vector3f extent = max - min;
+  return Vector3f(min.x + p[0] / 65535.0f * extent.x,
+                  min.y + p[1] / 65535.0f * extent.y,
+                  min.z + p[2] / 65535.0f * extent.z);
+}
+
+Matrix4f DequantizeTransform(const Vector3f& min, const Vector3f& max) {
+  const Vector3f extent = max - min;
+  return Matrix4f::TranslationTransform(min.x, min.y, min.z) *
+         Matrix4f::ScaleTransform(extent.x, extent.y, extent.z);
+}
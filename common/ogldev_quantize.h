@@ -0,0 +1,91 @@
+#ifndef OGLDEV_QUANTIZE_H
+#define OGLDEV_QUANTIZE_H
+
+#include <cstddef>
+
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Compact vertex attribute encodings.
+//
+//   attribute  float           quantized
+//   position   12 bytes        8 (half4, or unorm16x4 in a bounding box)
+//   normal     12 bytes        4 (10:10:10:2 snorm, or octahedral snorm16x2)
+//   uv          8 bytes        4 (half2)
+//
+// The batch encoders run four vertices at a time with ogldev_simd.h. Each
+// element gives the same result as the single-value function next to it.
+// VertexAttribFormat describes the result for glVertexAttribPointer (see
+// VertexAttribPointer() in tutorials/utility.h).
+
+// The GL enums used below, so that this header does not need the GL
+// headers.
+enum VertexAttribType : u32 {
+  kAttribShort = 0x1402,          // GL_SHORT
+  kAttribUnsignedShort = 0x1403,  // GL_UNSIGNED_SHORT
+  kAttribFloat = 0x1406,          // GL_FLOAT
+  kAttribHalfFloat = 0x140B,      // GL_HALF_FLOAT
+  kAttribInt2101010Rev = 0x8D9F,  // GL_INT_2_10_10_10_REV
+};
+
+struct VertexAttribFormat {
+  int size;  // Components, as passed to glVertexAttribPointer.
+  VertexAttribType type;
+  bool normalized;
+  u32 bytes;  // Size of one element.
+};
+
+constexpr VertexAttribFormat kFloat3Format = {3, kAttribFloat, false, 12};
+constexpr VertexAttribFormat kFloat2Format = {2, kAttribFloat, false, 8};
+// EncodeHalf() of Vector2f texture coordinates.
+constexpr VertexAttribFormat kHalf2Format = {2, kAttribHalfFloat, false, 4};
+// EncodePositionsHalf().
+constexpr VertexAttribFormat kHalf4Format = {4, kAttribHalfFloat, false, 8};
+// EncodeNormals1010102(). The shader sees the normal in xyz and 0 in w.
+constexpr VertexAttribFormat kNormal1010102Format = {4, kAttribInt2101010Rev,
+                                                     true, 4};
+// EncodeNormalsOct(). The shader decodes the vec2 as DecodeNormalOct() does.
+constexpr VertexAttribFormat kNormalOctFormat = {2, kAttribShort, true, 4};
+// EncodePositionsUnorm16(). The shader sees the position in [0, 1] and 1 in
+// w; DequantizeTransform() maps it back.
+constexpr VertexAttribFormat kUnorm16x4Format = {4, kAttribUnsignedShort,
+                                                 true, 8};
+
+// Half precision, rounding to nearest even. Out of range values become
+// infinity.
+u16 FloatToHalf(float f);
+float HalfToFloat(u16 h);
+
+void EncodeHalf(const float* in, u16* out, size_t count);
+void DecodeHalf(const u16* in, float* out, size_t count);
+
+// Four halves per position, the last one 1.0. |out| holds 4 * |count|.
+void EncodePositionsHalf(const Vector3f* in, u16* out, size_t count);
+
+// Signed normalized 10:10:10:2, as GL_INT_2_10_10_10_REV with w = 0.
+// Components are clamped to [-1, 1]; the maximum error is 1/1022.
+u32 EncodeNormal1010102(const Vector3f& n);
+Vector3f DecodeNormal1010102(u32 packed);
+void EncodeNormals1010102(const Vector3f* in, u32* out, size_t count);
+
+// Octahedral mapping of a unit vector to two snorm16 (x in the low half).
+// The angular error is below 0.04 degrees. A zero vector encodes as
+// (0, 0, 1).
+u32 EncodeNormalOct(const Vector3f& n);
+Vector3f DecodeNormalOct(u32 packed);
+void EncodeNormalsOct(const Vector3f* in, u32* out, size_t count);
+
+// Positions inside [min, max] as four unorm16 per position, the last one
+// 65535 (1.0). Positions outside the box are clamped to it. |out| holds
+// 4 * |count|.
+void EncodePositionsUnorm16(const Vector3f* in, size_t count,
+                            const Vector3f& min, const Vector3f& max,
+                            u16* out);
+Vector3f DecodePositionUnorm16(const u16* p, const Vector3f& min,
+                               const Vector3f& max);
+
+// Maps the [0, 1] positions seen by the shader back into [min, max].
+// Multiply it into the world matrix.
+Matrix4f DequantizeTransform(const Vector3f& min, const Vector3f& max);
+
+#endif  // OGLDEV_QUANTIZE_H
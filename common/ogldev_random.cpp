@@ -0,0 +1,174 @@
+#include "ogldev_random.h"
+
+#include <atomic>
+
+static u64 SplitMix64(u64& x) {
+  u64 z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static const float kTwoPi = 2.0f * static_cast<float>(M_PI);
+
+Random::Random(u64 seed, u64 stream) {
+  Seed(seed, stream);
+}
+
+void Random::Seed(u64 seed, u64 stream) {
+  u64 x = seed ^ (stream * 0xd1342543de82ef95ULL);
+
+  for (int lane = 0; lane < 4; lane++) {
+    const u64 a = SplitMix64(x);
+    const u64 b = SplitMix64(x);
+    state_[0][lane] = static_cast<u32>(a);
+    state_[1][lane] = static_cast<u32>(a >> 32);
+    state_[2][lane] = static_cast<u32>(b);
+    state_[3][lane] = static_cast<u32>(b >> 32);
+
+    // xoshiro must not start from the all-zero state.
+    if ((a | b) == 0) {
+      state_[0][lane] = 1;
+    }
+  }
+
+  buffered_ = 0;
+}
+
+simd::UInt4 Random::Next4() {
+  simd::UInt4 s0 = simd::LoadU4(state_[0]);
+  simd::UInt4 s1 = simd::LoadU4(state_[1]);
+  simd::UInt4 s2 = simd::LoadU4(state_[2]);
+  simd::UInt4 s3 = simd::LoadU4(state_[3]);
+
+  const simd::UInt4 result = simd::AddU4(s0, s3);
+  const simd::UInt4 t = simd::ShlU4<9>(s1);
+
+  s2 = simd::XorU4(s2, s0);
+  s3 = simd::XorU4(s3, s1);
+  s1 = simd::XorU4(s1, s2);
+  s0 = simd::XorU4(s0, s3);
+  s2 = simd::XorU4(s2, t);
+  s3 = simd::OrU4(simd::ShlU4<11>(s3), simd::ShrU4<21>(s3));
+
+  simd::StoreU4(state_[0], s0);
+  simd::StoreU4(state_[1], s1);
+  simd::StoreU4(state_[2], s2);
+  simd::StoreU4(state_[3], s3);
+
+  return result;
+}
+
+u32 Random::NextU32() {
+  if (buffered_ == 0) {
+    simd::StoreU4(buffer_, Next4());
+    buffered_ = 4;
+  }
+  return buffer_[--buffered_];
+}
+
+float Random::NextFloat() {
+  // The low bits of xoshiro128+ are weak, use the top 24.
+  return static_cast<float>(NextU32() >> 8) * (1.0f / 16777216.0f);
+}
+
+void Random::FillUniform(float* out, size_t count, float min, float max) {
+  const simd::Float4 vmin = simd::Splat4(min);
+  const simd::Float4 vrange = simd::Splat4(max - min);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Store4(out + i, simd::Add4(vmin, simd::Mul4(vrange, NextFloat4())));
+  }
+  for (; i < count; i++) {
+    out[i] = NextFloat(min, max);
+  }
+}
+
+void Random::FillUniform(Vector3f* out, size_t count, const Vector3f& min,
+                         const Vector3f& max) {
+  const Vector3f range = max - min;
+  const simd::Float4 min_x = simd::Splat4(min.x);
+  const simd::Float4 min_y = simd::Splat4(min.y);
+  const simd::Float4 min_z = simd::Splat4(min.z);
+  const simd::Float4 range_x = simd::Splat4(range.x);
+  const simd::Float4 range_y = simd::Splat4(range.y);
+  const simd::Float4 range_z = simd::Splat4(range.z);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const simd::Float4 x = simd::Add4(min_x, simd::Mul4(range_x, NextFloat4()));
+    const simd::Float4 y = simd::Add4(min_y, simd::Mul4(range_y, NextFloat4()));
+    const simd::Float4 z = simd::Add4(min_z, simd::Mul4(range_z, NextFloat4()));
+    simd::StoreInterleave3(&out[i].x, x, y, z);
+  }
+  for (; i < count; i++) {
+    const float x = NextFloat();
+    const float y = NextFloat();
+    const float z = NextFloat();
+    out[i] = Vector3f(min.x + range.x * x, min.y + range.y * y,
+                      min.z + range.z * z);
+  }
+}
+
+void Random::FillOnUnitSphere(Vector3f* out, size_t count) {
+  // z uniform in [-1, 1) and a uniform angle around the z axis give a
+  // uniform distribution on the sphere (Archimedes).
+  const simd::Float4 two = simd::Splat4(2.0f);
+  const simd::Float4 one = simd::Splat4(1.0f);
+  const simd::Float4 two_pi = simd::Splat4(kTwoPi);
+
+  for (size_t i = 0; i < count; i += 4) {
+    const simd::Float4 z = simd::Sub4(simd::Mul4(two, NextFloat4()), one);
+    const simd::Float4 r = simd::Sqrt4(simd::Sub4(one, simd::Mul4(z, z)));
+
+    float zs[4];
+    float rs[4];
+    float phis[4];
+    simd::Store4(zs, z);
+    simd::Store4(rs, r);
+    simd::Store4(phis, simd::Mul4(two_pi, NextFloat4()));
+
+    for (size_t k = 0; k < 4 && i + k < count; k++) {
+      float s, c;
+      SinCos(phis[k], s, c);
+      out[i + k] = Vector3f(rs[k] * c, rs[k] * s, zs[k]);
+    }
+  }
+}
+
+void Random::FillInUnitDisc(Vector2f* out, size_t count) {
+  // The square root of a uniform radius keeps the density uniform.
+  const simd::Float4 two_pi = simd::Splat4(kTwoPi);
+
+  for (size_t i = 0; i < count; i += 4) {
+    float rs[4];
+    float phis[4];
+    simd::Store4(rs, simd::Sqrt4(NextFloat4()));
+    simd::Store4(phis, simd::Mul4(two_pi, NextFloat4()));
+
+    for (size_t k = 0; k < 4 && i + k < count; k++) {
+      float s, c;
+      SinCos(phis[k], s, c);
+      out[i + k] = Vector2f(rs[k] * c, rs[k] * s);
+    }
+  }
+}
+
+static std::atomic<u64> g_thread_random_seed(Random::kDefaultSeed);
+static std::atomic<u64> g_next_thread_stream(0);
+
+static thread_local u64 t_thread_stream = 0;
+
+Random& ThreadRandom() {
+  thread_local Random random(
+      g_thread_random_seed.load(std::memory_order_relaxed),
+      t_thread_stream = g_next_thread_stream++);
+  return random;
+}
+
+void SeedThreadRandom(u64 seed) {
+  g_thread_random_seed.store(seed, std::memory_order_relaxed);
+  Random& random = ThreadRandom();
+  random.Seed(seed, t_thread_stream);
+}
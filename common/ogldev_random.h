@@ -0,0 +1,76 @@
+#ifndef OGLDEV_RANDOM_H
+#define OGLDEV_RANDOM_H
+
+#include <cstddef>
+
+#include "ogldev_math_3d.h"
+#include "ogldev_simd.h"
+#include "ogldev_types.h"
+
+// Fast, seedable pseudo random number generator.
+//
+// Four independent xoshiro128+ generators run side by side in the lanes of
+// a SIMD register, so the bulk Fill* functions produce four values per
+// step. The sequence depends only on (seed, stream) and on the order of the
+// calls, so e.g. giving every worker thread its own Random(seed, index)
+// makes parallel particle spawning reproducible.
+//
+// A Random object is not thread safe; use one per thread (see
+// ThreadRandom()).
+class Random {
+ public:
+  static const u64 kDefaultSeed = 0x853c49e6748fea9bULL;
+
+  // Different |stream| values give unrelated sequences for the same seed.
+  explicit Random(u64 seed = kDefaultSeed, u64 stream = 0);
+
+  void Seed(u64 seed, u64 stream = 0);
+
+  u32 NextU32();
+
+  // Uniform in [0, 1).
+  float NextFloat();
+
+  // Uniform in [min, max).
+  float NextFloat(float min, float max) {
+    return min + (max - min) * NextFloat();
+  }
+
+  // Uniform in [min, max).
+  void FillUniform(float* out, size_t count, float min = 0.0f,
+                   float max = 1.0f);
+
+  // Uniform in the box [min, max).
+  void FillUniform(Vector3f* out, size_t count, const Vector3f& min,
+                   const Vector3f& max);
+
+  // Uniformly distributed unit vectors (points on the unit sphere).
+  void FillOnUnitSphere(Vector3f* out, size_t count);
+
+  // Uniformly distributed points inside the unit disc.
+  void FillInUnitDisc(Vector2f* out, size_t count);
+
+ private:
+  // Advances all four lanes and returns their outputs.
+  simd::UInt4 Next4();
+
+  // Four uniform [0, 1) floats.
+  simd::Float4 NextFloat4() { return simd::ToUnitFloat4(Next4()); }
+
+  // state_[k][lane] is word k of the generator in |lane|.
+  u32 state_[4][4];
+  u32 buffer_[4];
+  int buffered_;
+};
+
+// Generator owned by the calling thread. Threads get distinct streams in
+// the order they first call this; for reproducible results across runs,
+// give workers explicitly seeded Random objects instead.
+Random& ThreadRandom();
+
+// Reseeds the calling thread's ThreadRandom() (keeping its stream) and sets
+// the seed of threads that have not called it yet. Defaults to
+// Random::kDefaultSeed. SRANDOM (ogldev_util.h) calls this.
+void SeedThreadRandom(u64 seed);
+
+#endif  // OGLDEV_RANDOM_H
@@ -0,0 +1,551 @@
+#ifndef OGLDEV_SIMD_H
+#define OGLDEV_SIMD_H
+
+// Thin 4-wide float abstraction used by the math code.
+//
+// The backend is chosen at compile time:
+//   - SSE2 on x86/x64 (always available on x64), plus AVX when the compiler
+//     is invoked with AVX enabled (e.g. -mavx, see OGLDEV_USE_AVX in CMake).
+//   - NEON on ARM.
+//   - A portable scalar fallback otherwise, or when OGLDEV_NO_SIMD is defined.
+//
+// Apart from RsqrtEstimate4() and the ARMv7 Div4() and RoundToInt4(), every
+// backend performs the same IEEE operations, so code written against this
+// header gives bit-identical results on all of them (as long as the
+// compiler does not contract mul + add into FMA).
+
+#include <math.h>
+#include <stdint.h>
+
+#if defined(OGLDEV_NO_SIMD)
+#define OGLDEV_SIMD_SCALAR 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OGLDEV_SIMD_SSE 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define OGLDEV_SIMD_AVX 1
+#endif
+#if defined(__F16C__)
+#define OGLDEV_SIMD_HALF 1
+#endif
+#if defined(__AVX__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OGLDEV_SIMD_NEON 1
+#if defined(__aarch64__)
+#define OGLDEV_SIMD_HALF 1
+#endif
+#include <arm_neon.h>
+#else
+#define OGLDEV_SIMD_SCALAR 1
+#endif
+
+namespace simd {
+
+#if defined(OGLDEV_SIMD_SSE)
+
+typedef __m128 Float4;
+
+inline Float4 Load4(const float* p) { return _mm_loadu_ps(p); }
+inline void Store4(float* p, Float4 v) { _mm_storeu_ps(p, v); }
+// |p| must be 16-byte aligned.
+inline Float4 Load4A(const float* p) { return _mm_load_ps(p); }
+inline void Store4A(float* p, Float4 v) { _mm_store_ps(p, v); }
+inline Float4 Splat4(float f) { return _mm_set1_ps(f); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Float4 Min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 Sqrt4(Float4 a) { return _mm_sqrt_ps(a); }
+
+// |a| with its sign flipped in the lanes where |s| is negative.
+inline Float4 FlipSign4(Float4 a, Float4 s) {
+  return _mm_xor_ps(a, _mm_and_ps(s, _mm_set1_ps(-0.0f)));
+}
+
+// Per-lane comparison results.
+typedef __m128 Mask4;
+
+inline Mask4 CmpGe4(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+inline Mask4 MaskAnd4(Mask4 a, Mask4 b) { return _mm_and_ps(a, b); }
+inline Mask4 MaskTrue4() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+// Bit i set if lane i is true.
+inline int MoveMask4(Mask4 m) { return _mm_movemask_ps(m); }
+// About 12 bits of precision.
+inline Float4 RsqrtEstimate4(Float4 a) { return _mm_rsqrt_ps(a); }
+
+inline void Transpose4(Float4& r0, Float4& r1, Float4& r2, Float4& r3) {
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+// Loads 4 packed xyz triples (12 floats) and splits them into x, y and z.
+inline void LoadDeinterleave3(const float* p, Float4& x, Float4& y,
+                              Float4& z) {
+  const __m128 a = _mm_loadu_ps(p);      // x0 y0 z0 x1
+  const __m128 b = _mm_loadu_ps(p + 4);  // y1 z1 x2 y2
+  const __m128 c = _mm_loadu_ps(p + 8);  // z2 x3 y3 z3
+  const __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+  const __m128 u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+  x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+  y = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3, 1, 2, 0));
+  z = _mm_shuffle_ps(u, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// Inverse of LoadDeinterleave3().
+inline void StoreInterleave3(float* p, Float4 x, Float4 y, Float4 z) {
+  const __m128 xy_lo = _mm_unpacklo_ps(x, y);  // x0 y0 x1 y1
+  const __m128 xy_hi = _mm_unpackhi_ps(x, y);  // x2 y2 x3 y3
+  const __m128 zx01 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+  const __m128 yz11 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 zx23 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+  const __m128 yz33 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+  _mm_storeu_ps(p, _mm_shuffle_ps(xy_lo, zx01, _MM_SHUFFLE(2, 0, 1, 0)));
+  _mm_storeu_ps(p + 4, _mm_shuffle_ps(yz11, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+  _mm_storeu_ps(p + 8, _mm_shuffle_ps(zx23, yz33, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+inline void Prefetch(const void* p) {
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+}
+
+// 4 x uint32, enough integer support for the random number generators.
+typedef __m128i UInt4;
+
+inline UInt4 LoadU4(const uint32_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+inline void StoreU4(uint32_t* p, UInt4 v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+inline UInt4 AddU4(UInt4 a, UInt4 b) { return _mm_add_epi32(a, b); }
+inline UInt4 XorU4(UInt4 a, UInt4 b) { return _mm_xor_si128(a, b); }
+inline UInt4 OrU4(UInt4 a, UInt4 b) { return _mm_or_si128(a, b); }
+template <int N>
+inline UInt4 ShlU4(UInt4 a) {
+  return _mm_slli_epi32(a, N);
+}
+template <int N>
+inline UInt4 ShrU4(UInt4 a) {
+  return _mm_srli_epi32(a, N);
+}
+
+// Maps the top 24 bits of each lane to a float in [0, 1).
+inline Float4 ToUnitFloat4(UInt4 a) {
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a, 8)),
+                    _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+inline UInt4 SplatU4(uint32_t u) {
+  return _mm_set1_epi32(static_cast<int>(u));
+}
+inline UInt4 AndU4(UInt4 a, UInt4 b) { return _mm_and_si128(a, b); }
+
+// Rounds to the nearest integer, ties to even, and returns it in two's
+// complement. Lanes must be within the int32 range.
+inline UInt4 RoundToInt4(Float4 a) { return _mm_cvtps_epi32(a); }
+
+inline Float4 Abs4(Float4 a) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+// Per lane, |a| where |m| is true and |b| elsewhere.
+inline Float4 Select4(Mask4 m, Float4 a, Float4 b) {
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+#elif defined(OGLDEV_SIMD_NEON)
+
+typedef float32x4_t Float4;
+
+inline Float4 Load4(const float* p) { return vld1q_f32(p); }
+inline void Store4(float* p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 Load4A(const float* p) { return vld1q_f32(p); }
+inline void Store4A(float* p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 Splat4(float f) { return vdupq_n_f32(f); }
+inline Float4 Add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+
+inline Float4 Div4(Float4 a, Float4 b) {
+#if defined(__aarch64__)
+  return vdivq_f32(a, b);
+#else
+  // ARMv7 has no vector divide: reciprocal estimate plus two Newton steps.
+  float32x4_t r = vrecpeq_f32(b);
+  r = vmulq_f32(vrecpsq_f32(b, r), r);
+  r = vmulq_f32(vrecpsq_f32(b, r), r);
+  return vmulq_f32(a, r);
+#endif
+}
+
+inline Float4 Min4(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+
+inline Float4 Sqrt4(Float4 a) {
+#if defined(__aarch64__)
+  return vsqrtq_f32(a);
+#else
+  float r[4];
+  vst1q_f32(r, a);
+  for (int i = 0; i < 4; i++) r[i] = sqrtf(r[i]);
+  return vld1q_f32(r);
+#endif
+}
+
+// About 8 bits of precision.
+inline Float4 RsqrtEstimate4(Float4 a) { return vrsqrteq_f32(a); }
+
+inline Float4 FlipSign4(Float4 a, Float4 s) {
+  const uint32x4_t sign =
+      vandq_u32(vreinterpretq_u32_f32(s), vdupq_n_u32(0x80000000u));
+  return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), sign));
+}
+
+typedef uint32x4_t Mask4;
+
+inline Mask4 CmpGe4(Float4 a, Float4 b) { return vcgeq_f32(a, b); }
+inline Mask4 MaskAnd4(Mask4 a, Mask4 b) { return vandq_u32(a, b); }
+inline Mask4 MaskTrue4() { return vdupq_n_u32(0xffffffffu); }
+
+inline int MoveMask4(Mask4 m) {
+  static const uint32_t kBits[4] = {1, 2, 4, 8};
+  const uint32x4_t b = vandq_u32(m, vld1q_u32(kBits));
+#if defined(__aarch64__)
+  return static_cast<int>(vaddvq_u32(b));
+#else
+  const uint32x2_t h = vadd_u32(vget_low_u32(b), vget_high_u32(b));
+  return static_cast<int>(vget_lane_u32(vpadd_u32(h, h), 0));
+#endif
+}
+
+inline void Transpose4(Float4& r0, Float4& r1, Float4& r2, Float4& r3) {
+  float32x4x2_t t01 = vtrnq_f32(r0, r1);
+  float32x4x2_t t23 = vtrnq_f32(r2, r3);
+  r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+  r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+  r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+  r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+inline void LoadDeinterleave3(const float* p, Float4& x, Float4& y,
+                              Float4& z) {
+  float32x4x3_t v = vld3q_f32(p);
+  x = v.val[0];
+  y = v.val[1];
+  z = v.val[2];
+}
+
+inline void StoreInterleave3(float* p, Float4 x, Float4 y, Float4 z) {
+  float32x4x3_t v;
+  v.val[0] = x;
+  v.val[1] = y;
+  v.val[2] = z;
+  vst3q_f32(p, v);
+}
+
+inline void Prefetch(const void* p) { __builtin_prefetch(p); }
+
+typedef uint32x4_t UInt4;
+
+inline UInt4 LoadU4(const uint32_t* p) { return vld1q_u32(p); }
+inline void StoreU4(uint32_t* p, UInt4 v) { vst1q_u32(p, v); }
+inline UInt4 AddU4(UInt4 a, UInt4 b) { return vaddq_u32(a, b); }
+inline UInt4 XorU4(UInt4 a, UInt4 b) { return veorq_u32(a, b); }
+inline UInt4 OrU4(UInt4 a, UInt4 b) { return vorrq_u32(a, b); }
+template <int N>
+inline UInt4 ShlU4(UInt4 a) {
+  return vshlq_n_u32(a, N);
+}
+template <int N>
+inline UInt4 ShrU4(UInt4 a) {
+  return vshrq_n_u32(a, N);
+}
+
+inline Float4 ToUnitFloat4(UInt4 a) {
+  return vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(a, 8)),
+                   vdupq_n_f32(1.0f / 16777216.0f));
+}
+
+inline UInt4 SplatU4(uint32_t u) { return vdupq_n_u32(u); }
+inline UInt4 AndU4(UInt4 a, UInt4 b) { return vandq_u32(a, b); }
+
+// ARMv7 has no round-to-nearest conversion; it rounds ties away from zero
+// instead of to even.
+inline UInt4 RoundToInt4(Float4 a) {
+#if defined(__aarch64__)
+  return vreinterpretq_u32_s32(vcvtnq_s32_f32(a));
+#else
+  const uint32x4_t sign =
+      vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x80000000u));
+  const float32x4_t half = vreinterpretq_f32_u32(
+      vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+  return vreinterpretq_u32_s32(vcvtq_s32_f32(vaddq_f32(a, half)));
+#endif
+}
+
+inline Float4 Abs4(Float4 a) { return vabsq_f32(a); }
+
+inline Float4 Select4(Mask4 m, Float4 a, Float4 b) {
+  return vbslq_f32(m, a, b);
+}
+
+#else  // Scalar fallback.
+
+struct Float4 {
+  float v[4];
+};
+
+inline Float4 Load4(const float* p) {
+  Float4 r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+inline void Store4(float* p, Float4 v) {
+  p[0] = v.v[0];
+  p[1] = v.v[1];
+  p[2] = v.v[2];
+  p[3] = v.v[3];
+}
+
+inline Float4 Load4A(const float* p) { return Load4(p); }
+inline void Store4A(float* p, Float4 v) { Store4(p, v); }
+
+inline Float4 Splat4(float f) {
+  Float4 r = {{f, f, f, f}};
+  return r;
+}
+
+inline Float4 Add4(Float4 a, Float4 b) {
+  Float4 r = {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2],
+               a.v[3] + b.v[3]}};
+  return r;
+}
+
+inline Float4 Sub4(Float4 a, Float4 b) {
+  Float4 r = {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2],
+               a.v[3] - b.v[3]}};
+  return r;
+}
+
+inline Float4 Mul4(Float4 a, Float4 b) {
+  Float4 r = {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2],
+               a.v[3] * b.v[3]}};
+  return r;
+}
+
+inline Float4 Div4(Float4 a, Float4 b) {
+  Float4 r = {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2],
+               a.v[3] / b.v[3]}};
+  return r;
+}
+
+inline Float4 Min4(Float4 a, Float4 b) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+  return r;
+}
+
+inline Float4 Max4(Float4 a, Float4 b) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+  return r;
+}
+
+inline Float4 Sqrt4(Float4 a) {
+  Float4 r = {{sqrtf(a.v[0]), sqrtf(a.v[1]), sqrtf(a.v[2]), sqrtf(a.v[3])}};
+  return r;
+}
+
+inline Float4 RsqrtEstimate4(Float4 a) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = 1.0f / sqrtf(a.v[i]);
+  return r;
+}
+
+inline Float4 FlipSign4(Float4 a, Float4 s) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = signbit(s.v[i]) ? -a.v[i] : a.v[i];
+  return r;
+}
+
+struct Mask4 {
+  bool v[4];
+};
+
+inline Mask4 CmpGe4(Float4 a, Float4 b) {
+  Mask4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] >= b.v[i];
+  return r;
+}
+
+inline Mask4 MaskAnd4(Mask4 a, Mask4 b) {
+  Mask4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] && b.v[i];
+  return r;
+}
+
+inline Mask4 MaskTrue4() {
+  Mask4 r = {{true, true, true, true}};
+  return r;
+}
+
+inline int MoveMask4(Mask4 m) {
+  return (m.v[0] ? 1 : 0) | (m.v[1] ? 2 : 0) | (m.v[2] ? 4 : 0) |
+         (m.v[3] ? 8 : 0);
+}
+
+inline void Transpose4(Float4& r0, Float4& r1, Float4& r2, Float4& r3) {
+  Float4 t0 = {{r0.v[0], r1.v[0], r2.v[0], r3.v[0]}};
+  Float4 t1 = {{r0.v[1], r1.v[1], r2.v[1], r3.v[1]}};
+  Float4 t2 = {{r0.v[2], r1.v[2], r2.v[2], r3.v[2]}};
+  Float4 t3 = {{r0.v[3], r1.v[3], r2.v[3], r3.v[3]}};
+  r0 = t0;
+  r1 = t1;
+  r2 = t2;
+  r3 = t3;
+}
+
+inline void LoadDeinterleave3(const float* p, Float4& x, Float4& y,
+                              Float4& z) {
+  for (int i = 0; i < 4; i++) {
+    x.v[i] = p[3 * i + 0];
+    y.v[i] = p[3 * i + 1];
+    z.v[i] = p[3 * i + 2];
+  }
+}
+
+inline void StoreInterleave3(float* p, Float4 x, Float4 y, Float4 z) {
+  for (int i = 0; i < 4; i++) {
+    p[3 * i + 0] = x.v[i];
+    p[3 * i + 1] = y.v[i];
+    p[3 * i + 2] = z.v[i];
+  }
+}
+
+inline void Prefetch(const void* p) {
+#if defined(__GNUC__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+struct UInt4 {
+  uint32_t v[4];
+};
+
+inline UInt4 LoadU4(const uint32_t* p) {
+  UInt4 r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+inline void StoreU4(uint32_t* p, UInt4 v) {
+  for (int i = 0; i < 4; i++) p[i] = v.v[i];
+}
+
+inline UInt4 AddU4(UInt4 a, UInt4 b) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] + b.v[i];
+  return r;
+}
+
+inline UInt4 XorU4(UInt4 a, UInt4 b) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] ^ b.v[i];
+  return r;
+}
+
+inline UInt4 OrU4(UInt4 a, UInt4 b) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] | b.v[i];
+  return r;
+}
+
+template <int N>
+inline UInt4 ShlU4(UInt4 a) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] << N;
+  return r;
+}
+
+template <int N>
+inline UInt4 ShrU4(UInt4 a) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] >> N;
+  return r;
+}
+
+inline Float4 ToUnitFloat4(UInt4 a) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = static_cast<float>(a.v[i] >> 8) * (1.0f / 16777216.0f);
+  }
+  return r;
+}
+
+inline UInt4 SplatU4(uint32_t u) {
+  UInt4 r = {{u, u, u, u}};
+  return r;
+}
+
+inline UInt4 AndU4(UInt4 a, UInt4 b) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = a.v[i] & b.v[i];
+  return r;
+}
+
+// lrintf() rounds ties to even in the default rounding mode, as SSE does.
+inline UInt4 RoundToInt4(Float4 a) {
+  UInt4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = static_cast<uint32_t>(static_cast<int32_t>(lrintf(a.v[i])));
+  }
+  return r;
+}
+
+inline Float4 Abs4(Float4 a) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = fabsf(a.v[i]);
+  return r;
+}
+
+inline Float4 Select4(Mask4 m, Float4 a, Float4 b) {
+  Float4 r;
+  for (int i = 0; i < 4; i++) r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+  return r;
+}
+
+#endif
+
+// Conversion to and from IEEE half precision, rounding to nearest even.
+// Only defined when OGLDEV_SIMD_HALF is: with F16C on x86 (-mf16c, or an
+// -march that has it) and on ARMv8.
+#if defined(OGLDEV_SIMD_HALF) && defined(OGLDEV_SIMD_SSE)
+
+inline void StoreHalf4(uint16_t* p, Float4 v) {
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(p),
+                   _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+inline Float4 LoadHalf4(const uint16_t* p) {
+  return _mm_cvtph_ps(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+#elif defined(OGLDEV_SIMD_HALF) && defined(OGLDEV_SIMD_NEON)
+
+inline void StoreHalf4(uint16_t* p, Float4 v) {
+  vst1_u16(p, vreinterpret_u16_f16(vcvt_f16_f32(v)));
+}
+inline Float4 LoadHalf4(const uint16_t* p) {
+  return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(p)));
+}
+
+#endif
+
+}  // namespace simd
+
+#endif  // OGLDEV_SIMD_H
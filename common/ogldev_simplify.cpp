@@ -0,0 +1,492 @@
+#include "ogldev_simplify.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <initializer_list>
+#include <thread>
+
+#include "ogldev_mesh_optimizer.h"
+
+// Weight of the planes that hold border edges in place, relative to the
+// triangle planes.
+static const double kBorderWeight = 10.0;
+// Cosine of the largest normal rotation a collapse may cause.
+static const float kMinFlipCos = 0.25f;
+
+namespace {
+
+enum VertexKind : u8 {
+  kInterior,
+  kBorder,
+  kLocked,
+};
+
+// Sum of squared distances to a set of weighted planes ax + by + cz + d,
+// as the upper triangle of the symmetric 4x4 matrix.
+struct Quadric {
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+  double weight;
+
+  void AddPlane(double a, double b, double c, double d, double w) {
+    a2 += w * a * a;
+    ab += w * a * b;
+    ac += w * a * c;
+    ad += w * a * d;
+    b2 += w * b * b;
+    bc += w * b * c;
+    bd += w * b * d;
+    c2 += w * c * c;
+    cd += w * c * d;
+    d2 += w * d * d;
+    weight += w;
+  }
+
+  void Add(const Quadric& q) {
+    a2 += q.a2;
+    ab += q.ab;
+    ac += q.ac;
+    ad += q.ad;
+    b2 += q.b2;
+    bc += q.bc;
+    bd += q.bd;
+    c2 += q.c2;
+    cd += q.cd;
+    d2 += q.d2;
+    weight += q.weight;
+  }
+
+  // Weighted mean squared distance of |p| to the planes.
+  double Error(const Vector3f& p) const {
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+    const double e = a2 * x * x + b2 * y * y + c2 * z * z +
+                     2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x +
+                            bd * y + cd * z) +
+                     d2;
+    return weight > 0.0 ? std::fabs(e) / weight : 0.0;
+  }
+};
+
+struct Collapse {
+  u32 from;
+  u32 to;
+  double error;  // Squared distance.
+
+  bool operator<(const Collapse& c) const { return error < c.error; }
+};
+
+u64 EdgeKey(u32 a, u32 b) {
+  return (static_cast<u64>(a) << 32) | b;
+}
+
+class Simplifier {
+ public:
+  Simplifier(const Vector3f* positions, size_t vertex_count)
+      : positions_(positions), vertex_count_(vertex_count) {}
+
+  // Returns the error reached.
+  float Run(std::vector<u32>& indices, size_t target_index_count,
+            float max_error);
+
+ private:
+  void Classify(const std::vector<u32>& indices);
+  void ComputeQuadrics(const std::vector<u32>& indices);
+  void BuildAdjacency(const std::vector<u32>& indices);
+  bool IsBorderEdge(u32 a, u32 b) const;
+  bool CanCollapse(u32 from, u32 to) const;
+  bool Flips(const std::vector<u32>& indices, u32 from, u32 to) const;
+  bool KeepsManifold(const std::vector<u32>& indices, u32 from, u32 to);
+
+  const Vector3f* positions_;
+  size_t vertex_count_;
+  std::vector<VertexKind> kind_;
+  std::vector<Quadric> quadrics_;
+
+  // Per pass: triangles around each vertex and the sorted directed edges.
+  std::vector<u32> offsets_;
+  std::vector<u32> adjacency_;
+  std::vector<u64> edges_;
+
+  // Scratch space for KeepsManifold().
+  std::vector<u32> ring_;
+  std::vector<u32> apexes_;
+};
+
+void Simplifier::Classify(const std::vector<u32>& indices) {
+  kind_.assign(vertex_count_, kInterior);
+
+  // Attribute seams: several referenced vertices at one position.
+  std::vector<u32> position_class(vertex_count_);
+  WeldVertices(positions_, vertex_count_, sizeof(Vector3f),
+               position_class.data());
+  std::vector<u8> referenced(vertex_count_, 0);
+  for (u32 v : indices) referenced[v] = 1;
+  std::vector<u32> class_size(vertex_count_, 0);
+  for (size_t v = 0; v < vertex_count_; v++) {
+    if (referenced[v]) class_size[position_class[v]]++;
+  }
+  for (size_t v = 0; v < vertex_count_; v++) {
+    if (class_size[position_class[v]] > 1) kind_[v] = kLocked;
+  }
+
+  // A border edge has no twin running the other way; an edge used twice in
+  // the same direction is non-manifold, and its vertices are locked.
+  BuildAdjacency(indices);
+  for (size_t i = 0; i < edges_.size(); i++) {
+    const u32 a = static_cast<u32>(edges_[i] >> 32);
+    const u32 b = static_cast<u32>(edges_[i]);
+    if (i + 1 < edges_.size() && edges_[i + 1] == edges_[i]) {
+      kind_[a] = kLocked;
+      kind_[b] = kLocked;
+    } else if (!std::binary_search(edges_.begin(), edges_.end(),
+                                   EdgeKey(b, a))) {
+      if (kind_[a] == kInterior) kind_[a] = kBorder;
+      if (kind_[b] == kInterior) kind_[b] = kBorder;
+    }
+  }
+}
+
+void Simplifier::ComputeQuadrics(const std::vector<u32>& indices) {
+  quadrics_.assign(vertex_count_, Quadric());
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    const Vector3f& p0 = positions_[indices[t]];
+    const Vector3f& p1 = positions_[indices[t + 1]];
+    const Vector3f& p2 = positions_[indices[t + 2]];
+    Vector3f n = (p1 - p0).Cross(p2 - p0);
+    const float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    if (length == 0.0f) continue;
+    n *= 1.0f / length;
+    const double area = 0.5 * length;
+    const double d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+    for (int k = 0; k < 3; k++) {
+      quadrics_[indices[t + k]].AddPlane(n.x, n.y, n.z, d, area);
+    }
+
+    // A plane through each border edge, perpendicular to the triangle,
+    // keeps the outline from shrinking.
+    for (int k = 0; k < 3; k++) {
+      const u32 a = indices[t + k];
+      const u32 b = indices[t + (k + 1) % 3];
+      if (kind_[a] == kInterior || kind_[b] == kInterior ||
+          !IsBorderEdge(a, b)) {
+        continue;
+      }
+      const Vector3f& pa = positions_[a];
+      Vector3f e = positions_[b] - pa;
+      const float edge_length2 = e.x * e.x + e.y * e.y + e.z * e.z;
+      Vector3f m = e.Cross(n);
+      const float m_length = sqrtf(m.x * m.x + m.y * m.y + m.z * m.z);
+      if (m_length == 0.0f) continue;
+      m *= 1.0f / m_length;
+      const double md = -(m.x * pa.x + m.y * pa.y + m.z * pa.z);
+      const double w = kBorderWeight * edge_length2;
+      quadrics_[a].AddPlane(m.x, m.y, m.z, md, w);
+      quadrics_[b].AddPlane(m.x, m.y, m.z, md, w);
+    }
+  }
+}
+
+void Simplifier::BuildAdjacency(const std::vector<u32>& indices) {
+  offsets_.assign(vertex_count_ + 1, 0);
+  for (u32 v : indices) offsets_[v + 1]++;
+  for (size_t v = 0; v < vertex_count_; v++) offsets_[v + 1] += offsets_[v];
+  adjacency_.resize(indices.size());
+  std::vector<u32> fill(offsets_.begin(), offsets_.end() - 1);
+  for (size_t i = 0; i < indices.size(); i++) {
+    adjacency_[fill[indices[i]]++] = static_cast<u32>(i / 3);
+  }
+
+  edges_.resize(indices.size());
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    for (int k = 0; k < 3; k++) {
+      edges_[t + k] = EdgeKey(indices[t + k], indices[t + (k + 1) % 3]);
+    }
+  }
+  std::sort(edges_.begin(), edges_.end());
+}
+
+bool Simplifier::IsBorderEdge(u32 a, u32 b) const {
+  return std::binary_search(edges_.begin(), edges_.end(), EdgeKey(a, b)) !=
+         std::binary_search(edges_.begin(), edges_.end(), EdgeKey(b, a));
+}
+
+bool Simplifier::CanCollapse(u32 from, u32 to) const {
+  switch (kind_[from]) {
+    case kInterior:
+      return true;
+    case kBorder:
+      // Along the border only, or the outline would be pinched.
+      return kind_[to] != kInterior && IsBorderEdge(from, to);
+    default:
+      return false;
+  }
+}
+
+// True if moving |from| onto |to| turns any surviving triangle around
+// |from| over.
+bool Simplifier::Flips(const std::vector<u32>& indices, u32 from,
+                       u32 to) const {
+  const Vector3f& target = positions_[to];
+  for (u32 i = offsets_[from]; i < offsets_[from + 1]; i++) {
+    const u32* tri = &indices[adjacency_[i] * 3];
+    if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+
+    const int k = tri[0] == from ? 0 : tri[1] == from ? 1 : 2;
+    const Vector3f& p1 = positions_[tri[(k + 1) % 3]];
+    const Vector3f& p2 = positions_[tri[(k + 2) % 3]];
+    const Vector3f& p0 = positions_[from];
+    const Vector3f before = (p1 - p0).Cross(p2 - p0);
+    const Vector3f after = (p1 - target).Cross(p2 - target);
+    const float dot = before.x * after.x + before.y * after.y +
+                      before.z * after.z;
+    const float before2 = before.x * before.x + before.y * before.y +
+                          before.z * before.z;
+    const float after2 =
+        after.x * after.x + after.y * after.y + after.z * after.z;
+    // More than about 75 degrees of rotation counts as a flip too: such
+    // slivers flip over in a later collapse.
+    if (dot <= kMinFlipCos * sqrtf(before2 * after2)) return true;
+  }
+  return false;
+}
+
+// True if the edge satisfies the link condition: the only vertices
+// adjacent to both |from| and |to| are the apexes of the triangles on the
+// edge (two inside, one on the border). Otherwise the collapse pinches the
+// surface, e.g. folds two triangles onto each other back to back, which the
+// per-triangle Flips() test cannot see.
+bool Simplifier::KeepsManifold(const std::vector<u32>& indices, u32 from,
+                               u32 to) {
+  ring_.clear();
+  apexes_.clear();
+  for (u32 i = offsets_[from]; i < offsets_[from + 1]; i++) {
+    const u32* tri = &indices[adjacency_[i] * 3];
+    const bool on_edge = tri[0] == to || tri[1] == to || tri[2] == to;
+    for (int k = 0; k < 3; k++) {
+      if (tri[k] == from || tri[k] == to) continue;
+      (on_edge ? apexes_ : ring_).push_back(tri[k]);
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+
+  for (u32 i = offsets_[to]; i < offsets_[to + 1]; i++) {
+    const u32* tri = &indices[adjacency_[i] * 3];
+    if (tri[0] == from || tri[1] == from || tri[2] == from) continue;
+    for (int k = 0; k < 3; k++) {
+      const u32 v = tri[k];
+      if (v == to || !std::binary_search(ring_.begin(), ring_.end(), v)) {
+        continue;
+      }
+      if (std::find(apexes_.begin(), apexes_.end(), v) == apexes_.end()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+float Simplifier::Run(std::vector<u32>& indices, size_t target_index_count,
+                      float max_error) {
+  Classify(indices);
+  ComputeQuadrics(indices);
+
+  const double max_error2 = static_cast<double>(max_error) * max_error;
+  double error2 = 0.0;
+  std::vector<Collapse> collapses;
+  std::vector<u32> target(vertex_count_, kNoVertex);
+  std::vector<u8> touched(vertex_count_);
+
+  while (indices.size() > target_index_count) {
+    // Adjacency of the current triangles; Classify() built the first one.
+    if (!collapses.empty()) BuildAdjacency(indices);
+
+    // The cheaper direction of each edge. Interior edges show up once per
+    // triangle side, which only costs a skipped duplicate later.
+    collapses.clear();
+    for (size_t t = 0; t < indices.size(); t += 3) {
+      for (int k = 0; k < 3; k++) {
+        const u32 a = indices[t + k];
+        const u32 b = indices[t + (k + 1) % 3];
+        Collapse best = {0, 0, DBL_MAX};
+        const u32 ends[2][2] = {{a, b}, {b, a}};
+        for (const auto& e : ends) {
+          if (!CanCollapse(e[0], e[1])) continue;
+          Quadric q = quadrics_[e[0]];
+          q.Add(quadrics_[e[1]]);
+          const double error = q.Error(positions_[e[1]]);
+          if (error < best.error) best = {e[0], e[1], error};
+        }
+        if (best.error <= max_error2) collapses.push_back(best);
+      }
+    }
+    if (collapses.empty()) break;
+
+    // Most collapses remove two triangles, and many are skipped below, so
+    // only the cheapest few times the number needed are sorted.
+    const size_t triangles_to_remove =
+        (indices.size() - target_index_count + 2) / 3;
+    const size_t candidates =
+        std::min(collapses.size(), triangles_to_remove * 4 + 1024);
+    std::nth_element(collapses.begin(), collapses.begin() + candidates - 1,
+                     collapses.end());
+    collapses.resize(candidates);
+    std::sort(collapses.begin(), collapses.end());
+
+    // Collapses whose 1-rings do not overlap see the adjacency and the
+    // quadrics computed for this pass.
+    std::fill(touched.begin(), touched.end(), 0);
+    size_t removed = 0;
+    size_t performed = 0;
+    for (const Collapse& c : collapses) {
+      if (removed >= triangles_to_remove) break;
+      if (touched[c.from] || touched[c.to]) continue;
+      if (Flips(indices, c.from, c.to)) continue;
+      if (!KeepsManifold(indices, c.from, c.to)) continue;
+
+      target[c.from] = c.to;
+      quadrics_[c.to].Add(quadrics_[c.from]);
+      error2 = std::max(error2, c.error);
+      performed++;
+
+      for (u32 v : {c.from, c.to}) {
+        for (u32 i = offsets_[v]; i < offsets_[v + 1]; i++) {
+          const u32* tri = &indices[adjacency_[i] * 3];
+          if (v == c.from &&
+              (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)) {
+            removed++;
+          }
+          touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+        }
+      }
+    }
+    if (performed == 0) break;
+
+    // Apply the collapses and drop the triangles that became degenerate.
+    size_t out = 0;
+    for (size_t t = 0; t < indices.size(); t += 3) {
+      u32 tri[3];
+      for (int k = 0; k < 3; k++) {
+        const u32 v = indices[t + k];
+        tri[k] = target[v] != kNoVertex ? target[v] : v;
+      }
+      if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) continue;
+      indices[out++] = tri[0];
+      indices[out++] = tri[1];
+      indices[out++] = tri[2];
+    }
+    indices.resize(out);
+    for (const Collapse& c : collapses) target[c.from] = kNoVertex;
+  }
+  return static_cast<float>(std::sqrt(error2));
+}
+
+}  // namespace
+
+size_t SimplifyMesh(const u32* indices, size_t index_count,
+                    const Vector3f* positions, size_t vertex_count,
+                    size_t target_index_count, float max_error, u32* out,
+                    float* result_error) {
+  std::vector<u32> result;
+  result.reserve(index_count);
+  for (size_t t = 0; t + 2 < index_count; t += 3) {
+    const u32* tri = indices + t;
+    if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) continue;
+    result.insert(result.end(), tri, tri + 3);
+  }
+
+  Simplifier simplifier(positions, vertex_count);
+  const float error =
+      simplifier.Run(result, target_index_count, max_error);
+  std::copy(result.begin(), result.end(), out);
+  if (result_error) *result_error = error;
+  return result.size();
+}
+
+void BuildLodChain(const u32* indices, size_t index_count,
+                   const Vector3f* positions, size_t vertex_count,
+                   const float* ratios, size_t ratio_count,
+                   std::vector<MeshLod>& lods) {
+  lods.clear();
+  const size_t triangle_count = index_count / 3;
+  for (size_t i = 0; i < ratio_count; i++) {
+    const size_t target = std::min(
+        triangle_count, static_cast<size_t>(triangle_count * ratios[i])) * 3;
+
+    MeshLod lod;
+    if (lods.empty()) {
+      lod.indices.resize(index_count);
+      lod.indices.resize(SimplifyMesh(indices, index_count, positions,
+                                      vertex_count, target, FLT_MAX,
+                                      lod.indices.data(), &lod.error));
+    } else {
+      // Simplifying the previous LOD is much cheaper than starting over;
+      // the errors add up to a bound for the distance to the input.
+      const MeshLod& prev = lods.back();
+      if (target >= prev.indices.size()) continue;
+      lod.indices.resize(prev.indices.size());
+      float error;
+      lod.indices.resize(SimplifyMesh(prev.indices.data(), prev.indices.size(),
+                                      positions, vertex_count, target,
+                                      FLT_MAX, lod.indices.data(), &error));
+      if (lod.indices.size() >= prev.indices.size()) break;
+      lod.error = prev.error + error;
+    }
+
+    OptimizeVertexCache(lod.indices.data(), lod.indices.size(),
+                        vertex_count);
+    lods.push_back(std::move(lod));
+  }
+}
+
+void BuildLodChains(const LodMeshInput* meshes, size_t mesh_count,
+                    const float* ratios, size_t ratio_count,
+                    std::vector<std::vector<MeshLod>>& lods,
+                    unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  lods.resize(mesh_count);
+
+  // Meshes are taken one at a time, so a few large meshes do not leave the
+  // other threads idle behind a static split.
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < mesh_count; i = next++) {
+      const LodMeshInput& m = meshes[i];
+      BuildLodChain(m.indices, m.index_count, m.positions, m.vertex_count,
+                    ratios, ratio_count, lods[i]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const size_t extra = std::min<size_t>(thread_count, mesh_count);
+  for (size_t t = 1; t < extra; t++) threads.emplace_back(worker);
+  worker();
+  for (std::thread& t : threads) t.join();
+}
+
+LodSelector::LodSelector(const PersProjInfo& info, float max_pixel_error)
+    : pixels_per_unit_(info.Height / (2.0f * tanf(ToRadian(info.FOV / 2.0f)))),
+      max_pixel_error_(max_pixel_error) {}
+
+size_t LodSelector::Select(const std::vector<MeshLod>& lods, float distance,
+                           float scale) const {
+  if (distance <= 0.0f) {
+    return 0;
+  }
+  const float pixels_per_error = scale * pixels_per_unit_ / distance;
+  for (size_t i = lods.size(); i-- > 1;) {
+    if (lods[i].error * pixels_per_error <= max_pixel_error_) return i;
+  }
+  return 0;
+}
+
+float LodSelector::ScreenSize(float radius, float distance) const {
+  if (distance <= radius) {
+    return FLT_MAX;
+  }
+  return 2.0f * radius * pixels_per_unit_ / distance;
+}
@@ -0,0 +1,90 @@
+#ifndef OGLDEV_SIMPLIFY_H
+#define OGLDEV_SIMPLIFY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Quadric error metric simplification (Garland and Heckbert) and LOD
+// chains.
+//
+// Simplification collapses edges onto one of their existing vertices, so
+// the result is a new index buffer over the same vertex buffer: all LODs of
+// a mesh share one vertex buffer and only the index range to draw changes.
+// Each pass sorts the candidate collapses by quadric error, performs the
+// cheapest ones whose neighborhoods do not overlap, and rejects those that
+// would flip a triangle.
+//
+// Border vertices only move along the border. Vertices that share their
+// position with another vertex (attribute seams) stay in place, so seams
+// never open.
+
+// Simplifies the triangle list to at most |target_index_count| indices, or
+// as close as possible without exceeding |max_error|, a distance in the
+// units of |positions|. Writes the result to |out| (at most |index_count|
+// entries), returns its index count and, if |result_error| is not null,
+// the error reached.
+size_t SimplifyMesh(const u32* indices, size_t index_count,
+                    const Vector3f* positions, size_t vertex_count,
+                    size_t target_index_count, float max_error, u32* out,
+                    float* result_error = nullptr);
+
+// One level of detail: the triangles to draw and how far, in object units,
+// they may be from the full-detail surface.
+struct MeshLod {
+  std::vector<u32> indices;
+  float error;
+};
+
+// Builds LODs at the given triangle ratios of the input (e.g. 1, 0.5, 0.25,
+// 0.125), each simplified from the previous one and reordered for the
+// vertex cache. A LOD that cannot get closer to its ratio than the previous
+// one ends the chain early.
+void BuildLodChain(const u32* indices, size_t index_count,
+                   const Vector3f* positions, size_t vertex_count,
+                   const float* ratios, size_t ratio_count,
+                   std::vector<MeshLod>& lods);
+
+struct LodMeshInput {
+  const u32* indices;
+  size_t index_count;
+  const Vector3f* positions;
+  size_t vertex_count;
+};
+
+// BuildLodChain() for each mesh, the meshes spread over |thread_count|
+// threads (0: one per hardware thread).
+void BuildLodChains(const LodMeshInput* meshes, size_t mesh_count,
+                    const float* ratios, size_t ratio_count,
+                    std::vector<std::vector<MeshLod>>& lods,
+                    unsigned thread_count = 0);
+
+// Picks LODs by their projected error for a perspective projection:
+//
+//   LodSelector selector(proj_info);
+//   const MeshLod& lod = lods[selector.Select(lods, distance, scale)];
+class LodSelector {
+ public:
+  explicit LodSelector(const PersProjInfo& info, float max_pixel_error = 1.0f);
+
+  // Index of the coarsest LOD whose error, scaled by the object's world
+  // |scale|, covers at most max_pixel_error pixels at |distance| from the
+  // camera.
+  size_t Select(const std::vector<MeshLod>& lods, float distance,
+                float scale = 1.0f) const;
+
+  // Projected diameter in pixels of a bounding sphere, e.g. to skip objects
+  // that cover only a few pixels.
+  float ScreenSize(float radius, float distance) const;
+
+  // Pixels covered by one world unit at distance 1.
+  float pixels_per_unit() const { return pixels_per_unit_; }
+
+ private:
+  float pixels_per_unit_;
+  float max_pixel_error_;
+};
+
+#endif  // OGLDEV_SIMPLIFY_H
@@ -0,0 +1,172 @@
+#include "ogldev_transform_batch.h"
+
+#include "ogldev_simd.h"
+
+// How far ahead of the current element the input is prefetched.
+static const size_t kPrefetchBytes = 512;
+
+namespace {
+
+// The matrix elements splatted into all four lanes, so that four elements
+// laid out as x[4], y[4], z[4], w[4] can be transformed at once.
+struct SplatMatrix {
+  simd::Float4 e[4][4];
+
+  explicit SplatMatrix(const Matrix4f& m) {
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        e[i][j] = simd::Splat4(m.m[i][j]);
+      }
+    }
+  }
+
+  // Row |i| dotted with (x, y, z, w), summed left to right like the scalar
+  // Matrix4f::operator*(const Vector4f&).
+  simd::Float4 Row(int i, simd::Float4 x, simd::Float4 y, simd::Float4 z,
+                   simd::Float4 w) const {
+    simd::Float4 r = simd::Mul4(e[i][0], x);
+    r = simd::Add4(r, simd::Mul4(e[i][1], y));
+    r = simd::Add4(r, simd::Mul4(e[i][2], z));
+    return simd::Add4(r, simd::Mul4(e[i][3], w));
+  }
+
+  // Row |i| with w == 1 (m[i][3] * 1 is exact, so this matches Row()).
+  simd::Float4 RowPoint(int i, simd::Float4 x, simd::Float4 y,
+                        simd::Float4 z) const {
+    simd::Float4 r = simd::Mul4(e[i][0], x);
+    r = simd::Add4(r, simd::Mul4(e[i][1], y));
+    r = simd::Add4(r, simd::Mul4(e[i][2], z));
+    return simd::Add4(r, e[i][3]);
+  }
+
+  // Row |i| with w == 0.
+  simd::Float4 RowDirection(int i, simd::Float4 x, simd::Float4 y,
+                            simd::Float4 z) const {
+    simd::Float4 r = simd::Mul4(e[i][0], x);
+    r = simd::Add4(r, simd::Mul4(e[i][1], y));
+    return simd::Add4(r, simd::Mul4(e[i][2], z));
+  }
+};
+
+Vector3f TransformOne(const Matrix4f& m, const Vector3f& v, float w,
+                      bool perspective_divide) {
+  Vector4f r = m * Vector4f(v.x, v.y, v.z, w);
+  if (perspective_divide) {
+    return Vector3f(r.x / r.w, r.y / r.w, r.z / r.w);
+  }
+  return Vector3f(r.x, r.y, r.z);
+}
+
+}  // namespace
+
+void TransformPoints(const Matrix4f& m, const Vector3f* in, Vector3f* out,
+                     size_t count, bool perspective_divide) {
+  const SplatMatrix sm(m);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Prefetch(reinterpret_cast<const char*>(in + i) + kPrefetchBytes);
+
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+
+    simd::Float4 rx = sm.RowPoint(0, x, y, z);
+    simd::Float4 ry = sm.RowPoint(1, x, y, z);
+    simd::Float4 rz = sm.RowPoint(2, x, y, z);
+
+    if (perspective_divide) {
+      const simd::Float4 rw = sm.RowPoint(3, x, y, z);
+      rx = simd::Div4(rx, rw);
+      ry = simd::Div4(ry, rw);
+      rz = simd::Div4(rz, rw);
+    }
+
+    simd::StoreInterleave3(&out[i].x, rx, ry, rz);
+  }
+
+  for (; i < count; i++) {
+    out[i] = TransformOne(m, in[i], 1.0f, perspective_divide);
+  }
+}
+
+void TransformDirections(const Matrix4f& m, const Vector3f* in,
+                         Vector3f* out, size_t count) {
+  const SplatMatrix sm(m);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Prefetch(reinterpret_cast<const char*>(in + i) + kPrefetchBytes);
+
+    simd::Float4 x, y, z;
+    simd::LoadDeinterleave3(&in[i].x, x, y, z);
+
+    simd::StoreInterleave3(&out[i].x, sm.RowDirection(0, x, y, z),
+                           sm.RowDirection(1, x, y, z),
+                           sm.RowDirection(2, x, y, z));
+  }
+
+  for (; i < count; i++) {
+    out[i] = TransformOne(m, in[i], 0.0f, false);
+  }
+}
+
+void TransformVectors(const Matrix4f& m, const Vector4f* in, Vector4f* out,
+                      size_t count, bool perspective_divide) {
+  const SplatMatrix sm(m);
+  const simd::Float4 one = simd::Splat4(1.0f);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Prefetch(reinterpret_cast<const char*>(in + i) + kPrefetchBytes);
+
+    simd::Float4 x = simd::Load4(&in[i + 0].x);
+    simd::Float4 y = simd::Load4(&in[i + 1].x);
+    simd::Float4 z = simd::Load4(&in[i + 2].x);
+    simd::Float4 w = simd::Load4(&in[i + 3].x);
+    simd::Transpose4(x, y, z, w);
+
+    simd::Float4 rx = sm.Row(0, x, y, z, w);
+    simd::Float4 ry = sm.Row(1, x, y, z, w);
+    simd::Float4 rz = sm.Row(2, x, y, z, w);
+    simd::Float4 rw = sm.Row(3, x, y, z, w);
+
+    if (perspective_divide) {
+      rx = simd::Div4(rx, rw);
+      ry = simd::Div4(ry, rw);
+      rz = simd::Div4(rz, rw);
+      rw = one;
+    }
+
+    simd::Transpose4(rx, ry, rz, rw);
+    simd::Store4(&out[i + 0].x, rx);
+    simd::Store4(&out[i + 1].x, ry);
+    simd::Store4(&out[i + 2].x, rz);
+    simd::Store4(&out[i + 3].x, rw);
+  }
+
+  for (; i < count; i++) {
+    Vector4f r = m * in[i];
+    if (perspective_divide) {
+      r = Vector4f(r.x / r.w, r.y / r.w, r.z / r.w, 1.0f);
+    }
+    out[i] = r;
+  }
+}
+
+void InitTRSBatch(const Vector3f* translation, const Vector3f* rotation,
+                  const Vector3f* scale, Matrix4f* out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    simd::Prefetch(reinterpret_cast<const char*>(rotation + i) +
+                   kPrefetchBytes);
+    out[i].InitTRS(translation[i], rotation[i], scale[i]);
+  }
+}
+
+void InitTRSBatch(const Vector3f* translation, const Quaternion* rotation,
+                  const Vector3f* scale, Matrix4f* out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    simd::Prefetch(reinterpret_cast<const char*>(rotation + i) +
+                   kPrefetchBytes);
+    out[i].InitTRS(translation[i], rotation[i], scale[i]);
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef OGLDEV_TRANSFORM_BATCH_H
+#define OGLDEV_TRANSFORM_BATCH_H
+
+#include <cstddef>
+
+#include "ogldev_math_3d.h"
+
+// Batch transforms of contiguous arrays by one Matrix4f.
+//
+// The arrays are processed four elements at a time with the SIMD backend
+// from ogldev_simd.h, prefetching ahead of the input. Each element gives
+// exactly the same result as the single-vector Matrix4f::operator*.
+//
+// |in| and |out| may point to the same array (in-place transform) but must
+// not overlap otherwise.
+
+// out[i] = (m * (in[i], 1)).xyz, or divided by w if |perspective_divide|.
+void TransformPoints(const Matrix4f& m, const Vector3f* in, Vector3f* out,
+                     size_t count, bool perspective_divide = false);
+
+// out[i] = (m * (in[i], 0)).xyz, i.e. the translation is ignored.
+void TransformDirections(const Matrix4f& m, const Vector3f* in,
+                         Vector3f* out, size_t count);
+
+// out[i] = m * in[i], or (xyz / w, 1) if |perspective_divide|.
+void TransformVectors(const Matrix4f& m, const Vector4f* in, Vector4f* out,
+                      size_t count, bool perspective_divide = false);
+
+// out[i].InitTRS(translation[i], rotation[i], scale[i]) for |count|
+// transforms. Rotations are Euler angles in degrees.
+void InitTRSBatch(const Vector3f* translation, const Vector3f* rotation,
+                  const Vector3f* scale, Matrix4f* out, size_t count);
+
+// Same with quaternion rotations.
+void InitTRSBatch(const Vector3f* translation, const Quaternion* rotation,
+                  const Vector3f* scale, Matrix4f* out, size_t count);
+
+#endif  // OGLDEV_TRANSFORM_BATCH_H
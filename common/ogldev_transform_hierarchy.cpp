@@ -0,0 +1,184 @@
+#include "ogldev_transform_hierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+const u32 TransformHierarchy::kNoParent;
+
+// Below this many dirty nodes Update() stays on the calling thread.
+static const size_t kMinParallelNodes = 2048;
+
+// world_dirty_ values.
+static const u8 kClean = 0;
+static const u8 kHead = 1;
+static const u8 kBelowHead = 2;
+
+u32 TransformHierarchy::Add(u32 parent, const Vector3f& translation,
+                            const Quaternion& rotation,
+                            const Vector3f& scale) {
+  assert(parent == kNoParent || parent < size());
+
+  const u32 node = static_cast<u32>(size());
+  parent_.push_back(parent);
+  translation_.push_back(translation);
+  rotation_.push_back(rotation);
+  scale_.push_back(scale);
+  world_.push_back(Matrix4f::Identity());
+  dirty_.push_back(0);
+  world_dirty_.push_back(kClean);
+  group_.push_back(0);
+
+  MarkDirty(node);
+  return node;
+}
+
+void TransformHierarchy::MarkDirty(u32 node) {
+  if (dirty_[node]) {
+    return;
+  }
+
+  dirty_[node] = 1;
+  first_dirty_ = dirty_count_ == 0 ? node : std::min(first_dirty_, node);
+  dirty_count_++;
+}
+
+void TransformHierarchy::SetTranslation(u32 node,
+                                        const Vector3f& translation) {
+  translation_[node] = translation;
+  MarkDirty(node);
+}
+
+void TransformHierarchy::SetRotation(u32 node, const Quaternion& rotation) {
+  rotation_[node] = rotation;
+  MarkDirty(node);
+}
+
+void TransformHierarchy::SetScale(u32 node, const Vector3f& scale) {
+  scale_[node] = scale;
+  MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocal(u32 node, const Vector3f& translation,
+                                  const Quaternion& rotation,
+                                  const Vector3f& scale) {
+  translation_[node] = translation;
+  rotation_[node] = rotation;
+  scale_[node] = scale;
+  MarkDirty(node);
+}
+
+void TransformHierarchy::UpdateNode(u32 node) {
+  Matrix4f local;
+  local.InitTRS(translation_[node], rotation_[node], scale_[node]);
+
+  const u32 parent = parent_[node];
+  world_[node] = parent == kNoParent ? local : world_[parent] * local;
+}
+
+u32 TransformHierarchy::CollectDirty() {
+  order_.clear();
+  u32 group_count = 0;
+
+  const u32 n = static_cast<u32>(size());
+  for (u32 i = first_dirty_; i < n; i++) {
+    const u32 parent = parent_[i];
+    const u8 parent_state = parent == kNoParent ? kClean : world_dirty_[parent];
+
+    if (parent_state == kClean) {
+      if (!dirty_[i]) continue;
+      world_dirty_[i] = kHead;
+    } else {
+      world_dirty_[i] = kBelowHead;
+      group_[i] = parent_state == kHead ? group_count++ : group_[parent];
+    }
+    order_.push_back(i);
+  }
+
+  return group_count;
+}
+
+void TransformHierarchy::Update(unsigned thread_count) {
+  if (dirty_count_ == 0) {
+    return;
+  }
+
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  const u32 group_count = CollectDirty();
+
+  if (thread_count == 1 || group_count < 2 ||
+      order_.size() < kMinParallelNodes) {
+    for (u32 node : order_) {
+      UpdateNode(node);
+    }
+  } else {
+    UpdateParallel(group_count, thread_count);
+  }
+
+  for (u32 node : order_) {
+    world_dirty_[node] = kClean;
+    dirty_[node] = 0;
+  }
+  dirty_count_ = 0;
+}
+
+void TransformHierarchy::UpdateParallel(u32 group_count,
+                                        unsigned thread_count) {
+  // The heads only depend on clean parents and are few; do them first, then
+  // the groups below them are independent of each other.
+  std::vector<u32> group_size(group_count, 0);
+  for (u32 node : order_) {
+    if (world_dirty_[node] == kHead) {
+      UpdateNode(node);
+    } else {
+      group_size[group_[node]]++;
+    }
+  }
+
+  // Largest groups first, each to the least loaded thread.
+  std::vector<u32> by_size(group_count);
+  for (u32 g = 0; g < group_count; g++) by_size[g] = g;
+  std::sort(by_size.begin(), by_size.end(),
+            [&](u32 a, u32 b) { return group_size[a] > group_size[b]; });
+
+  thread_count = std::min<unsigned>(thread_count, group_count);
+  std::vector<size_t> load(thread_count, 0);
+  std::vector<u32> group_thread(group_count);
+  for (u32 g : by_size) {
+    const size_t t = std::min_element(load.begin(), load.end()) - load.begin();
+    group_thread[g] = static_cast<u32>(t);
+    load[t] += group_size[g];
+  }
+
+  // Stable bucket sort of the nodes by thread, which keeps parents before
+  // their children.
+  std::vector<size_t> begin(thread_count + 1, 0);
+  for (unsigned t = 0; t < thread_count; t++) {
+    begin[t + 1] = begin[t] + load[t];
+  }
+  thread_order_.resize(begin[thread_count]);
+  std::vector<size_t> fill(begin.begin(), begin.end() - 1);
+  for (u32 node : order_) {
+    if (world_dirty_[node] == kBelowHead) {
+      thread_order_[fill[group_thread[group_[node]]]++] = node;
+    }
+  }
+
+  auto run = [&](unsigned t) {
+    for (size_t k = begin[t]; k < begin[t + 1]; k++) {
+      UpdateNode(thread_order_[k]);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < thread_count; t++) {
+    workers.emplace_back(run, t);
+  }
+  run(0);
+  for (std::thread& w : workers) {
+    w.join();
+  }
+}
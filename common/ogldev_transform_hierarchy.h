@@ -0,0 +1,86 @@
+#ifndef OGLDEV_TRANSFORM_HIERARCHY_H
+#define OGLDEV_TRANSFORM_HIERARCHY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "ogldev_aligned.h"
+#include "ogldev_math_3d.h"
+#include "ogldev_types.h"
+
+// Parent/child transforms stored as flat arrays indexed by node.
+//
+// A node can only be added below an existing node, so parents always have
+// smaller indices than their children and one forward sweep visits the
+// nodes in topological order. Each node keeps its local translation,
+// rotation and scale and its world matrix, parent world * local TRS.
+//
+// Changing a local transform only flags the node. Update() recomputes the
+// world matrices of the flagged nodes and their descendants and nothing
+// else: nodes before the first flagged one are not touched, later static
+// nodes cost one flag test. With several threads, the subtrees below the
+// topmost dirty nodes are updated in parallel.
+class TransformHierarchy {
+ public:
+  static const u32 kNoParent = 0xffffffff;
+
+  TransformHierarchy() : first_dirty_(0), dirty_count_(0) {}
+
+  // Adds a node below |parent| (kNoParent for a root) and returns its index.
+  u32 Add(u32 parent, const Vector3f& translation, const Quaternion& rotation,
+          const Vector3f& scale);
+
+  void SetTranslation(u32 node, const Vector3f& translation);
+  void SetRotation(u32 node, const Quaternion& rotation);
+  void SetScale(u32 node, const Vector3f& scale);
+  void SetLocal(u32 node, const Vector3f& translation,
+                const Quaternion& rotation, const Vector3f& scale);
+
+  // Recomputes the world matrices that changed since the last call.
+  // |thread_count| 0 means one thread per hardware thread.
+  void Update(unsigned thread_count = 1);
+
+  size_t size() const { return parent_.size(); }
+  u32 parent(u32 node) const { return parent_[node]; }
+  const Vector3f& translation(u32 node) const { return translation_[node]; }
+  const Quaternion& rotation(u32 node) const { return rotation_[node]; }
+  const Vector3f& scale(u32 node) const { return scale_[node]; }
+
+  // Valid after Update().
+  const Matrix4f& world(u32 node) const { return world_[node]; }
+  // All world matrices, e.g. for a uniform or storage buffer upload.
+  const Matrix4f* world_matrices() const { return world_.data(); }
+
+ private:
+  void MarkDirty(u32 node);
+
+  // world_[node] = world_[parent] * local TRS.
+  void UpdateNode(u32 node);
+
+  // Fills order_ with the nodes to recompute, parents before children, and
+  // returns the number of independent subtree groups (see group_).
+  u32 CollectDirty();
+
+  void UpdateParallel(u32 group_count, unsigned thread_count);
+
+  std::vector<u32> parent_;
+  std::vector<Vector3f> translation_;
+  std::vector<Quaternion> rotation_;
+  std::vector<Vector3f> scale_;
+  AlignedVector<Matrix4f> world_;
+
+  // Local transform changed since the last Update().
+  std::vector<u8> dirty_;
+  u32 first_dirty_;
+  size_t dirty_count_;
+
+  // Scratch for Update(). world_dirty_ is kHead for the topmost nodes of
+  // dirty subtrees and kBelowHead for the nodes under them; group_ numbers
+  // the subtrees rooted at the children of the heads.
+  std::vector<u8> world_dirty_;
+  std::vector<u32> group_;
+  std::vector<u32> order_;
+  std::vector<u32> thread_order_;
+};
+
+#endif  // OGLDEV_TRANSFORM_HIERARCHY_H
@@ -1,9 +1,7 @@
-#include <fstream>
-#include <iostream>
 #ifdef WIN32
 #include <Windows.h>
 #else
-#include <sys/time.h>
+#include <time.h>
 #endif
 
 #include <cerrno>
@@ -13,88 +11,106 @@
 #include <sys/types.h>
 
 #include "ogldev_util.h"
-
-bool ReadFile(const char* pFileName, std::string& outFile) {
-  std::ifstream f(pFileName);
-
-  bool ret = false;
-
-  if (f.is_open()) {
-    std::string line;
-    while (getline(f, line)) {
-      outFile.append(line);
-      outFile.append("\n");
+#include "ogldev_mapped_file.h"
+#include "ogldev_profiler.h"
+
+// Appends everything |read_fn| returns until it reports end of file. The
+// buffer is sized once from |size_hint| (plus one byte, so that the read
+// that detects the end needs no reallocation) and only grows if the file
+// turns out to be larger.
+template <typename ReadFn>
+static bool ReadToEnd(ReadFn read_fn, size_t size_hint, std::string& out) {
+  size_t pos = out.size();
+  out.resize(pos + size_hint + 1);
+
+  for (;;) {
+    if (pos == out.size()) {
+      out.resize(out.size() + out.size() / 2 + 4096);
     }
 
-    f.close();
-
-    ret = true;
-  } else {
-    OGLDEV_FILE_ERROR(pFileName);
+    const long long n = read_fn(&out[pos], out.size() - pos);
+    if (n < 0) {
+      out.resize(pos);
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    pos += static_cast<size_t>(n);
   }
 
-  return ret;
+  out.resize(pos);
+  return true;
 }
 
 #ifdef WIN32
 
-char* ReadBinaryFile(const char* pFileName, int& size) {
-  HANDLE f = CreateFileA(pFileName, GENERIC_READ, 0, NULL, OPEN_EXISTING,
-                         FILE_ATTRIBUTE_NORMAL, NULL);
-
-  if (f == INVALID_HANDLE_VALUE) {
+bool ReadFile(const char* pFileName, std::string& outFile) {
+  OGLDEV_PROFILE_FUNCTION();
+  FILE* f = fopen(pFileName, "rb");
+  if (!f) {
     OGLDEV_FILE_ERROR(pFileName);
     return false;
   }
 
-  size = GetFileSize(f, NULL);
+  struct _stat64 stat_buf;
+  const size_t size_hint =
+      _fstat64(_fileno(f), &stat_buf) == 0 ? (size_t)stat_buf.st_size : 0;
 
-  if (size == INVALID_FILE_SIZE) {
-    OGLDEV_ERROR("Invalid file size %s\n", pFileName);
-    return false;
-  }
+  const bool ret = ReadToEnd(
+      [f](char* p, size_t n) -> long long {
+        const size_t read_len = fread(p, 1, n, f);
+        return read_len == 0 && ferror(f) ? -1 : (long long)read_len;
+      },
+      size_hint, outFile);
 
-  // wip for tutorial51
-  assert(0);
+  if (!ret) {
+    OGLDEV_ERROR("Error reading '%s'\n", pFileName);
+  }
 
-  return true;
+  fclose(f);
+  return ret;
 }
 
 #else
-char* ReadBinaryFile(const char* pFileName, int& size) {
-  int f = open(pFileName, O_RDONLY);
 
+bool ReadFile(const char* pFileName, std::string& outFile) {
+  OGLDEV_PROFILE_FUNCTION();
+  int f = open(pFileName, O_RDONLY);
   if (f == -1) {
-    OGLDEV_ERROR("Error opening '%s': %s\n", pFileName, strerror(errno));
-    return NULL;
+    OGLDEV_FILE_ERROR(pFileName);
+    return false;
   }
 
   struct stat stat_buf;
-  int error = stat(pFileName, &stat_buf);
-
-  if (error) {
-    OGLDEV_ERROR("Error getting file stats: %s\n", strerror(errno));
-    return NULL;
-  }
-
-  size = stat_buf.st_size;
-
-  char* p = (char*)malloc(size);
-  assert(p);
-
-  int read_len = read(f, p, size);
-
-  if (read_len != size) {
-    OGLDEV_ERROR("Error reading file: %s\n", strerror(errno));
-    return NULL;
+  const size_t size_hint =
+      fstat(f, &stat_buf) == 0 ? (size_t)stat_buf.st_size : 0;
+
+  const bool ret = ReadToEnd(
+      [f](char* p, size_t n) -> long long {
+        for (;;) {
+          const ssize_t read_len = read(f, p, n);
+          if (read_len >= 0 || errno != EINTR) {
+            return read_len;
+          }
+        }
+      },
+      size_hint, outFile);
+
+  if (!ret) {
+    OGLDEV_ERROR("Error reading '%s': %s\n", pFileName, strerror(errno));
   }
 
   close(f);
-
-  return p;
+  return ret;
 }
+
 #endif
 
+bool ReadFile(const char* pFileName, MappedFile& file) {
+  return file.Open(pFileName);
+}
+
 void OgldevError(const char* pFileName, uint line, const char* format, ...) {
   char msg[1000];
   va_list args;
@@ -102,35 +118,35 @@ void OgldevError(const char* pFileName, uint line, const char* format, ...) {
   VSNPRINTF(msg, sizeof(msg), format, args);
   va_end(args);
 
-#ifdef WIN32
-  char msg2[1000];
-  _snprintf_s(msg2, sizeof(msg2), "%s:%d: %s", pFileName, line, msg);
-  MessageBoxA(NULL, msg2, NULL, 0);
-#else
-  fprintf(stderr, "%s:%d - %s", pFileName, line, msg);
-#endif
+  OgldevLog(kLogError, pFileName, line, "%s", msg);
 }
 
 void OgldevFileError(const char* pFileName, uint line, const char* pFileError) {
+  OgldevLog(kLogError, pFileName, line, "unable to open file `%s`\n",
+            pFileError);
+}
+
+u64 GetTimeNs() {
 #ifdef WIN32
-  char msg[1000];
-  _snprintf_s(msg, sizeof(msg), "%s:%d: unable to open file `%s`", pFileName,
-              line, pFileError);
-  MessageBoxA(NULL, msg, NULL, 0);
+  static const u64 frequency = []() {
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return static_cast<u64>(f.QuadPart);
+  }();
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  const u64 ticks = static_cast<u64>(counter.QuadPart);
+  // Split so that ticks * 10^9 cannot overflow.
+  return ticks / frequency * 1000000000ull +
+         ticks % frequency * 1000000000ull / frequency;
 #else
-  fprintf(stderr, "%s:%d: unable to open file `%s`\n", pFileName, line,
-          pFileError);
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<u64>(t.tv_sec) * 1000000000ull +
+         static_cast<u64>(t.tv_nsec);
 #endif
 }
 
 long long GetCurrentTimeMillis() {
-#ifdef WIN32
-  return GetTickCount();
-#else
-  timeval t;
-  gettimeofday(&t, NULL);
-
-  long long ret = t.tv_sec * 1000 + t.tv_usec / 1000;
-  return ret;
-#endif
+  return static_cast<long long>(GetTimeNs() / 1000000);
 }
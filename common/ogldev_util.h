@@ -11,17 +11,31 @@
 #include <cstring>
 #include <cassert>
 
+#include "ogldev_log.h"
 #include "ogldev_types.h"
 
+class MappedFile;
+
+// Appends the contents of the file to |outFile|, byte for byte.
 bool ReadFile(const char* fileName, std::string& outFile);
-char* ReadBinaryFile(const char* pFileName, int& size);
+// Maps the file instead of copying it (see MappedFile).
+bool ReadFile(const char* fileName, MappedFile& file);
 
+// Format immediately, then log asynchronously at kLogError (see
+// ogldev_log.h). The macros below are cheaper: they defer the formatting to
+// the logging thread.
 void OgldevError(const char* pFileName, uint line, const char* msg, ... );
 void OgldevFileError(const char* pFileName, uint line, const char* pFileError);
 
-#define OGLDEV_ERROR0(msg) OgldevError(__FILE__, __LINE__, msg)
-#define OGLDEV_ERROR(msg, ...) OgldevError(__FILE__, __LINE__, msg, __VA_ARGS__)
-#define OGLDEV_FILE_ERROR(FileError) OgldevFileError(__FILE__, __LINE__, FileError);
+// |msg| must be a string literal: "" msg does not compile otherwise.
+#define OGLDEV_LOG(level, msg, ...) \
+    OgldevLog(level, __FILE__, __LINE__, "" msg, ##__VA_ARGS__)
+#define OGLDEV_ERROR0(msg) OgldevLog(kLogError, __FILE__, __LINE__, "" msg)
+#define OGLDEV_ERROR(msg, ...) \
+    OgldevLog(kLogError, __FILE__, __LINE__, "" msg, __VA_ARGS__)
+#define OGLDEV_FILE_ERROR(FileError) \
+    OgldevLog(kLogError, __FILE__, __LINE__, "unable to open file `%s`\n", \
+              FileError);
 
 #define ZERO_MEM(a) memset(a, 0, sizeof(a))
 #define ZERO_MEM_VAR(var) memset(&var, 0, sizeof(var))
@@ -31,16 +45,21 @@ void OgldevFileError(const char* pFileName, uint line, const char* pFileError);
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #endif
 
+// Defined in ogldev_random.cpp; seeds ThreadRandom() and so RandomFloat().
+void SeedThreadRandom(u64 seed);
+
+// SRANDOM seeds both RANDOM and RandomFloat().
 #ifdef WIN32
 #define SNPRINTF _snprintf_s
 #define VSNPRINTF vsnprintf_s
 #define RANDOM rand
-#define SRANDOM srand((unsigned)time(NULL))
+#define SRANDOM \
+    (srand((unsigned)time(NULL)), SeedThreadRandom((u64)time(NULL)))
 #else
 #define SNPRINTF snprintf
 #define VSNPRINTF vsnprintf
 #define RANDOM random
-#define SRANDOM srandom(getpid())
+#define SRANDOM (srandom(getpid()), SeedThreadRandom((u64)getpid()))
 #endif
 
 #define INVALID_UNIFORM_LOCATION 0xffffffff
@@ -60,6 +79,10 @@ void OgldevFileError(const char* pFileName, uint line, const char* pFileError);
 
 #define GLCheckError() (glGetError() == GL_NO_ERROR)
 
+// Nanoseconds from a monotonic clock with an unspecified origin; only
+// differences are meaningful.
+u64 GetTimeNs();
+// GetTimeNs() in milliseconds.
 long long GetCurrentTimeMillis();
 
 
@@ -0,0 +1,273 @@
+#include "ogldev_vector_soa.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+#include "ogldev_aligned.h"
+#include "ogldev_simd.h"
+
+static size_t RoundUpLane(size_t size) {
+  const size_t m = Vector3fSoA::kLaneMultiple;
+  return (size + m - 1) / m * m;
+}
+
+Vector3fSoA::Vector3fSoA() : size_(0), capacity_(0), data_(NULL) {}
+
+Vector3fSoA::Vector3fSoA(size_t size) : size_(0), capacity_(0), data_(NULL) {
+  Resize(size);
+}
+
+Vector3fSoA::Vector3fSoA(const Vector3f* v, size_t count)
+    : size_(0), capacity_(0), data_(NULL) {
+  FromAoS(v, count);
+}
+
+Vector3fSoA::Vector3fSoA(const Vector3fSoA& rhs)
+    : size_(0), capacity_(0), data_(NULL) {
+  *this = rhs;
+}
+
+Vector3fSoA& Vector3fSoA::operator=(const Vector3fSoA& rhs) {
+  if (this != &rhs) {
+    Resize(rhs.size_);
+    std::copy(rhs.x(), rhs.x() + rhs.size_, x());
+    std::copy(rhs.y(), rhs.y() + rhs.size_, y());
+    std::copy(rhs.z(), rhs.z() + rhs.size_, z());
+  }
+  return *this;
+}
+
+Vector3fSoA::Vector3fSoA(Vector3fSoA&& rhs)
+    : size_(rhs.size_), capacity_(rhs.capacity_), data_(rhs.data_) {
+  rhs.size_ = 0;
+  rhs.capacity_ = 0;
+  rhs.data_ = NULL;
+}
+
+Vector3fSoA& Vector3fSoA::operator=(Vector3fSoA&& rhs) {
+  if (this != &rhs) {
+    AlignedFree(data_);
+    size_ = rhs.size_;
+    capacity_ = rhs.capacity_;
+    data_ = rhs.data_;
+    rhs.size_ = 0;
+    rhs.capacity_ = 0;
+    rhs.data_ = NULL;
+  }
+  return *this;
+}
+
+Vector3fSoA::~Vector3fSoA() {
+  AlignedFree(data_);
+}
+
+void Vector3fSoA::Resize(size_t size) {
+  const size_t capacity = RoundUpLane(size);
+
+  if (capacity != capacity_) {
+    float* data = NULL;
+    if (capacity > 0) {
+      data = static_cast<float*>(
+          AlignedMalloc(3 * capacity * sizeof(float), kAlignment));
+      if (data == NULL) {
+        throw std::bad_alloc();
+      }
+      std::fill(data, data + 3 * capacity, 0.0f);
+
+      const size_t keep = std::min(size_, size);
+      for (size_t lane = 0; lane < 3; lane++) {
+        std::copy(data_ + lane * capacity_, data_ + lane * capacity_ + keep,
+                  data + lane * capacity);
+      }
+    }
+
+    AlignedFree(data_);
+    data_ = data;
+    capacity_ = capacity;
+  } else {
+    // The kernels run over the padding too and may have left anything
+    // there (Normalize() makes NaNs), so clear everything past the
+    // elements kept, not just the elements removed.
+    const size_t keep = std::min(size_, size);
+    std::fill(x() + keep, x() + capacity_, 0.0f);
+    std::fill(y() + keep, y() + capacity_, 0.0f);
+    std::fill(z() + keep, z() + capacity_, 0.0f);
+  }
+
+  size_ = size;
+}
+
+void Vector3fSoA::FromAoS(const Vector3f* v, size_t count) {
+  Resize(count);
+
+  float* px = x();
+  float* py = y();
+  float* pz = z();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    simd::Float4 vx, vy, vz;
+    simd::LoadDeinterleave3(&v[i].x, vx, vy, vz);
+    simd::Store4A(px + i, vx);
+    simd::Store4A(py + i, vy);
+    simd::Store4A(pz + i, vz);
+  }
+
+  for (; i < count; i++) {
+    Set(i, v[i]);
+  }
+}
+
+void Vector3fSoA::ToAoS(Vector3f* v) const {
+  const float* px = x();
+  const float* py = y();
+  const float* pz = z();
+
+  size_t i = 0;
+  for (; i + 4 <= size_; i += 4) {
+    simd::StoreInterleave3(&v[i].x, simd::Load4A(px + i),
+                           simd::Load4A(py + i), simd::Load4A(pz + i));
+  }
+
+  for (; i < size_; i++) {
+    v[i] = Get(i);
+  }
+}
+
+void Dot(const Vector3fSoA& a, const Vector3fSoA& b, float* out) {
+  assert(a.size() == b.size());
+
+  const size_t n = a.size();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const simd::Float4 dx =
+        simd::Mul4(simd::Load4A(a.x() + i), simd::Load4A(b.x() + i));
+    const simd::Float4 dy =
+        simd::Mul4(simd::Load4A(a.y() + i), simd::Load4A(b.y() + i));
+    const simd::Float4 dz =
+        simd::Mul4(simd::Load4A(a.z() + i), simd::Load4A(b.z() + i));
+    simd::Store4(out + i, simd::Add4(simd::Add4(dx, dy), dz));
+  }
+
+  for (; i < n; i++) {
+    out[i] = a.x()[i] * b.x()[i] + a.y()[i] * b.y()[i] + a.z()[i] * b.z()[i];
+  }
+}
+
+void Cross(const Vector3fSoA& a, const Vector3fSoA& b, Vector3fSoA& out) {
+  assert(a.size() == b.size());
+
+  out.Resize(a.size());
+
+  // Padded lanes: no scalar tail needed.
+  const size_t n = a.padded_size();
+  for (size_t i = 0; i < n; i += 4) {
+    const simd::Float4 ax = simd::Load4A(a.x() + i);
+    const simd::Float4 ay = simd::Load4A(a.y() + i);
+    const simd::Float4 az = simd::Load4A(a.z() + i);
+    const simd::Float4 bx = simd::Load4A(b.x() + i);
+    const simd::Float4 by = simd::Load4A(b.y() + i);
+    const simd::Float4 bz = simd::Load4A(b.z() + i);
+
+    // Same formula as Vector3f::Cross().
+    simd::Store4A(out.x() + i,
+                  simd::Sub4(simd::Mul4(ay, bz), simd::Mul4(az, by)));
+    simd::Store4A(out.y() + i,
+                  simd::Sub4(simd::Mul4(az, bx), simd::Mul4(ax, bz)));
+    simd::Store4A(out.z() + i,
+                  simd::Sub4(simd::Mul4(ax, by), simd::Mul4(ay, bx)));
+  }
+}
+
+void Normalize(Vector3fSoA& v, NormalizeMode mode) {
+  const simd::Float4 half = simd::Splat4(0.5f);
+  const simd::Float4 three_halves = simd::Splat4(1.5f);
+
+  const size_t n = v.padded_size();
+  for (size_t i = 0; i < n; i += 4) {
+    const simd::Float4 x = simd::Load4A(v.x() + i);
+    const simd::Float4 y = simd::Load4A(v.y() + i);
+    const simd::Float4 z = simd::Load4A(v.z() + i);
+
+    simd::Float4 len2 = simd::Mul4(x, x);
+    len2 = simd::Add4(len2, simd::Mul4(y, y));
+    len2 = simd::Add4(len2, simd::Mul4(z, z));
+
+    if (mode == kNormalizeExact) {
+      const simd::Float4 len = simd::Sqrt4(len2);
+      simd::Store4A(v.x() + i, simd::Div4(x, len));
+      simd::Store4A(v.y() + i, simd::Div4(y, len));
+      simd::Store4A(v.z() + i, simd::Div4(z, len));
+    } else {
+      // r' = r * (1.5 - 0.5 * len2 * r * r)
+      simd::Float4 r = simd::RsqrtEstimate4(len2);
+      const simd::Float4 hlr2 =
+          simd::Mul4(simd::Mul4(half, len2), simd::Mul4(r, r));
+      r = simd::Mul4(r, simd::Sub4(three_halves, hlr2));
+
+      simd::Store4A(v.x() + i, simd::Mul4(x, r));
+      simd::Store4A(v.y() + i, simd::Mul4(y, r));
+      simd::Store4A(v.z() + i, simd::Mul4(z, r));
+    }
+  }
+}
+
+void Lerp(const Vector3fSoA& a, const Vector3fSoA& b, float t,
+          Vector3fSoA& out) {
+  assert(a.size() == b.size());
+
+  out.Resize(a.size());
+
+  const simd::Float4 vt = simd::Splat4(t);
+  const float* pa[3] = {a.x(), a.y(), a.z()};
+  const float* pb[3] = {b.x(), b.y(), b.z()};
+  float* po[3] = {out.x(), out.y(), out.z()};
+
+  const size_t n = a.padded_size();
+  for (size_t lane = 0; lane < 3; lane++) {
+    for (size_t i = 0; i < n; i += 4) {
+      const simd::Float4 va = simd::Load4A(pa[lane] + i);
+      const simd::Float4 vb = simd::Load4A(pb[lane] + i);
+      simd::Store4A(po[lane] + i,
+                    simd::Add4(va, simd::Mul4(simd::Sub4(vb, va), vt)));
+    }
+  }
+}
+
+void MinMax(const Vector3fSoA& v, Vector3f& min, Vector3f& max) {
+  assert(!v.empty());
+
+  const float* p[3] = {v.x(), v.y(), v.z()};
+  float lo[3];
+  float hi[3];
+
+  const size_t n = v.size();
+  for (size_t lane = 0; lane < 3; lane++) {
+    simd::Float4 vlo = simd::Splat4(p[lane][0]);
+    simd::Float4 vhi = vlo;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const simd::Float4 c = simd::Load4A(p[lane] + i);
+      vlo = simd::Min4(vlo, c);
+      vhi = simd::Max4(vhi, c);
+    }
+
+    float l[4];
+    float h[4];
+    simd::Store4(l, vlo);
+    simd::Store4(h, vhi);
+
+    lo[lane] = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+    hi[lane] = std::max(std::max(h[0], h[1]), std::max(h[2], h[3]));
+
+    for (; i < n; i++) {
+      lo[lane] = std::min(lo[lane], p[lane][i]);
+      hi[lane] = std::max(hi[lane], p[lane][i]);
+    }
+  }
+
+  min = Vector3f(lo[0], lo[1], lo[2]);
+  max = Vector3f(hi[0], hi[1], hi[2]);
+}
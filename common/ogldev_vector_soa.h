@@ -0,0 +1,94 @@
+#ifndef OGLDEV_VECTOR_SOA_H
+#define OGLDEV_VECTOR_SOA_H
+
+#include <cstddef>
+
+#include "ogldev_math_3d.h"
+
+// An array of Vector3f stored as structure of arrays: all x, then all y,
+// then all z. Each lane starts on a kAlignment boundary and is padded to
+// a multiple of kLaneMultiple floats, so kernels can always run on full
+// SIMD registers. The padding is zero-initialized and its content after a
+// kernel runs is unspecified.
+class Vector3fSoA {
+ public:
+  static const size_t kAlignment = 64;
+  static const size_t kLaneMultiple = 16;
+
+  Vector3fSoA();
+  explicit Vector3fSoA(size_t size);
+  Vector3fSoA(const Vector3f* v, size_t count);
+
+  Vector3fSoA(const Vector3fSoA& rhs);
+  Vector3fSoA& operator=(const Vector3fSoA& rhs);
+  Vector3fSoA(Vector3fSoA&& rhs);
+  Vector3fSoA& operator=(Vector3fSoA&& rhs);
+
+  ~Vector3fSoA();
+
+  // Existing elements are kept, new elements are zero.
+  void Resize(size_t size);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // size() rounded up to kLaneMultiple.
+  size_t padded_size() const { return capacity_; }
+
+  float* x() { return data_; }
+  float* y() { return data_ + capacity_; }
+  float* z() { return data_ + 2 * capacity_; }
+  const float* x() const { return data_; }
+  const float* y() const { return data_ + capacity_; }
+  const float* z() const { return data_ + 2 * capacity_; }
+
+  Vector3f Get(size_t i) const { return Vector3f(x()[i], y()[i], z()[i]); }
+
+  void Set(size_t i, const Vector3f& v) {
+    x()[i] = v.x;
+    y()[i] = v.y;
+    z()[i] = v.z;
+  }
+
+  // Replaces the content with |count| vectors from an AoS array.
+  void FromAoS(const Vector3f* v, size_t count);
+
+  // Writes size() vectors to an AoS array.
+  void ToAoS(Vector3f* v) const;
+
+ private:
+  size_t size_;
+  size_t capacity_;
+  float* data_;
+};
+
+enum NormalizeMode {
+  // sqrt and divide, same result as Vector3f::Normalize().
+  kNormalizeExact,
+  // Reciprocal square root estimate refined by one Newton-Raphson step
+  // (about 22 bits of precision with SSE).
+  kNormalizeFast,
+};
+
+// Batch kernels. |out| is resized to the input size and may alias an input.
+// Binary kernels require both inputs to have the same size.
+
+// out[i] = dot(a[i], b[i]). |out| must hold a.size() floats.
+void Dot(const Vector3fSoA& a, const Vector3fSoA& b, float* out);
+
+// out[i] = cross(a[i], b[i]).
+void Cross(const Vector3fSoA& a, const Vector3fSoA& b, Vector3fSoA& out);
+
+// Normalizes every vector in place. Zero vectors become NaN, like
+// Vector3f::Normalize().
+void Normalize(Vector3fSoA& v, NormalizeMode mode = kNormalizeExact);
+
+// out[i] = a[i] + (b[i] - a[i]) * t.
+void Lerp(const Vector3fSoA& a, const Vector3fSoA& b, float t,
+          Vector3fSoA& out);
+
+// Component-wise minimum and maximum over all vectors. |v| must not be
+// empty.
+void MinMax(const Vector3fSoA& v, Vector3f& min, Vector3f& max);
+
+#endif  // OGLDEV_VECTOR_SOA_H
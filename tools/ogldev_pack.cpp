@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "ogldev_archive.h"
+#include "ogldev_util.h"
+
+// Packs every file below a directory into one asset archive (see
+// common/ogldev_archive.h). Entry names are the paths relative to the
+// directory, with '/' separators.
+//
+//   ogldev_pack [-c] <directory> <archive>
+//
+// -c stores compressible entries LZ4-compressed.
+
+// Appends the paths of the files below |dir| + "/" + |relative| to |out|,
+// relative to |dir|, in a stable order.
+static bool ListFiles(const std::string& dir, const std::string& relative,
+                      std::vector<std::string>& out) {
+  const std::string path = relative.empty() ? dir : dir + "/" + relative;
+  std::vector<std::string> names;
+  std::vector<bool> is_dir;
+
+#ifdef WIN32
+  _finddata_t data;
+  intptr_t handle = _findfirst((path + "/*").c_str(), &data);
+  if (handle == -1) {
+    OGLDEV_FILE_ERROR(path.c_str());
+    return false;
+  }
+  do {
+    if (strcmp(data.name, ".") && strcmp(data.name, "..")) {
+      names.push_back(data.name);
+      is_dir.push_back((data.attrib & _A_SUBDIR) != 0);
+    }
+  } while (_findnext(handle, &data) == 0);
+  _findclose(handle);
+#else
+  DIR* d = opendir(path.c_str());
+  if (!d) {
+    OGLDEV_FILE_ERROR(path.c_str());
+    return false;
+  }
+  while (dirent* entry = readdir(d)) {
+    if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+      continue;
+    }
+    struct stat stat_buf;
+    const std::string child = path + "/" + entry->d_name;
+    if (stat(child.c_str(), &stat_buf) != 0) {
+      continue;
+    }
+    names.push_back(entry->d_name);
+    is_dir.push_back(S_ISDIR(stat_buf.st_mode));
+  }
+  closedir(d);
+#endif
+
+  // readdir order is arbitrary; sort so that archives are reproducible.
+  std::vector<size_t> order(names.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return names[a] < names[b]; });
+
+  for (size_t i : order) {
+    const std::string child =
+        relative.empty() ? names[i] : relative + "/" + names[i];
+    if (is_dir[i]) {
+      if (!ListFiles(dir, child, out)) {
+        return false;
+      }
+    } else {
+      out.push_back(child);
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  bool compress = false;
+  int arg = 1;
+  if (arg < argc && strcmp(argv[arg], "-c") == 0) {
+    compress = true;
+    arg++;
+  }
+  if (argc - arg != 2) {
+    fprintf(stderr, "Usage: %s [-c] <directory> <archive>\n", argv[0]);
+    return 1;
+  }
+
+  const std::string dir = argv[arg];
+  std::vector<std::string> files;
+  if (!ListFiles(dir, "", files)) {
+    return 1;
+  }
+
+  ArchiveWriter writer;
+  size_t total = 0;
+  for (const std::string& name : files) {
+    std::string contents;
+    if (!ReadFile((dir + "/" + name).c_str(), contents)) {
+      return 1;
+    }
+    writer.Add(name, contents.data(), contents.size(), compress);
+    total += contents.size();
+  }
+
+  if (!writer.Write(argv[arg + 1])) {
+    return 1;
+  }
+
+  printf("Packed %zu files, %zu bytes, into %s\n", files.size(), total,
+         argv[arg + 1]);
+  return 0;
+}
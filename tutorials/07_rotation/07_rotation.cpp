@@ -1,11 +1,14 @@
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <string>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "ogldev_frame_stats.h"
 #include "ogldev_math_3d.h"
+#include "ogldev_profiler.h"
 #include "utility.h"
 
 // 这个例子与 06_translation 几乎一样，除了矩阵不同。
@@ -13,7 +16,27 @@
 GLuint g_vbo;
 GLuint g_world_location;
 
+// With the OGLDEV_TRACE environment variable set, startup and the first
+// kTraceFrames frames are written to kTraceFile as a Chrome trace.
+static const int kTraceFrames = 300;
+static const char kTraceFile[] = "07_rotation_trace.json";
+
+// Set when the OGLDEV_FRAME_STATS environment variable is.
+static FrameStats* g_frame_stats = nullptr;
+static GpuTimer* g_gpu_timer = nullptr;
+
 static void RenderSceneCB() {
+  static int frame = 0;
+  if (ProfilerActive() && ++frame > kTraceFrames) {
+    ProfilerStop();
+    WriteChromeTrace(kTraceFile);
+  }
+  OGLDEV_PROFILE_FUNCTION();
+  if (g_frame_stats) {
+    g_frame_stats->BeginFrame();
+    g_gpu_timer->Begin();
+  }
+
   glClear(GL_COLOR_BUFFER_BIT);
 
   static float scale = 0.0f;
@@ -35,15 +58,33 @@ static void RenderSceneCB() {
   // 注意最后一个参数不能直接写成 world.m，因为它的类型是 float (*)[4]。
   glUniformMatrix4fv(g_world_location, 1, GL_TRUE, &world.m[0][0]);
 
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  {
+    OGLDEV_PROFILE_SCOPE("Draw");
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, g_vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-  glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
 
-  glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(0);
+  }
 
+  if (g_frame_stats) {
+    g_gpu_timer->End();
+    GLuint64 gpu_ns;
+    while (g_gpu_timer->Poll(&gpu_ns)) {
+      g_frame_stats->AddGpuTime(gpu_ns);
+    }
+    g_frame_stats->BeginSwap();
+  }
+
+  // Blocks when the driver runs ahead of the GPU or waits for vsync.
+  OGLDEV_PROFILE_SCOPE("glutSwapBuffers");
   glutSwapBuffers();
+
+  if (g_frame_stats) {
+    g_frame_stats->EndFrame();
+  }
 }
 
 static void InitializeGlutCallbacks() {
@@ -63,6 +104,11 @@ static void CreateVertexBuffer() {
 }
 
 int main(int argc, char** argv) {
+  if (getenv("OGLDEV_TRACE")) {
+    ProfilerSetThreadName("main");
+    ProfilerStart();
+  }
+
   glutInitContextVersion(4, 5);
   glutInitContextProfile(GLUT_CORE_PROFILE);
 
@@ -100,6 +146,18 @@ int main(int argc, char** argv) {
   g_world_location = glGetUniformLocation(shader_program, "gWorld");
   assert(g_world_location != 0xFFFFFFFF);
 
+  // Frame times are reported every 5 seconds, appended to the file that
+  // OGLDEV_FRAME_STATS names, or to stdout if it is empty.
+  if (const char* stats_path = getenv("OGLDEV_FRAME_STATS")) {
+    FILE* out = *stats_path ? fopen(stats_path, "a") : stdout;
+    if (!out) {
+      fprintf(stderr, "Error opening '%s'\n", stats_path);
+      return 1;
+    }
+    g_frame_stats = new FrameStats("07_rotation", out);
+    g_gpu_timer = new GpuTimer();
+  }
+
   glutMainLoop();
 
   return 0;
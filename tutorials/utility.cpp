@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <string>
 
+#include "ogldev_profiler.h"
 #include "ogldev_util.h"
 
 static const char* DescribeError(GLenum gl_error) {
@@ -30,6 +31,7 @@ void CheckError() {
 }
 
 GLuint LoadShader(const char* shader_filename, GLenum shader_type) {
+  OGLDEV_PROFILE_FUNCTION();
   std::string shader_text;
   if (!ReadFile(shader_filename, shader_text)) {
     exit(1);
@@ -47,13 +49,17 @@ GLuint LoadShader(const char* shader_filename, GLenum shader_type) {
   GLint lengths[1] = {(GLint)shader_text.size()};
   glShaderSource(shader, 1, texts, lengths);
 
-  glCompileShader(shader);
-
   // 检查编译状态，显示编译错误。
   // glGetShaderiv 中的 'iv' 代表 vector of int，详见：
   //   https://stackoverflow.com/a/15440261
+  // Drivers may compile in the background; the status query waits for it,
+  // so the zone covers both calls.
   GLint status = GL_FALSE;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  {
+    OGLDEV_PROFILE_SCOPE("CompileShader");
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  }
   if (status != GL_TRUE) {
     GLchar info_log[1024];
     glGetShaderInfoLog(shader, 1024, NULL, info_log);
@@ -67,6 +73,7 @@ GLuint LoadShader(const char* shader_filename, GLenum shader_type) {
 
 GLuint CreateProgram(const char* vert_shader_path,
                      const char* frag_shader_path) {
+  OGLDEV_PROFILE_FUNCTION();
   // Load and compile the vertex and fragment shaders.
   GLuint vert_shader = LoadShader(vert_shader_path, GL_VERTEX_SHADER);
   GLuint frag_shader = LoadShader(frag_shader_path, GL_FRAGMENT_SHADER);
@@ -88,11 +95,13 @@ GLuint CreateProgram(const char* vert_shader_path,
   glDeleteShader(vert_shader);
   glDeleteShader(frag_shader);
 
-  glLinkProgram(shader_program);
-
   GLint status = 0;
   GLchar error_log[1024] = {0};
-  glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
+  {
+    OGLDEV_PROFILE_SCOPE("LinkProgram");
+    glLinkProgram(shader_program);
+    glGetProgramiv(shader_program, GL_LINK_STATUS, &status);
+  }
   if (status != GL_TRUE) {
     glGetProgramInfoLog(shader_program, sizeof(error_log), NULL, error_log);
     fprintf(stderr, "Error linking shader program: '%s'\n", error_log);
@@ -117,3 +126,50 @@ GLuint CreateProgram(const char* vert_shader_path,
 
   return shader_program;
 }
+
+GpuTimer::GpuTimer() : issued_(0), read_(0), active_(false) {
+  glGenQueries(kQueryCount, queries_);
+}
+
+GpuTimer::~GpuTimer() {
+  glDeleteQueries(kQueryCount, queries_);
+}
+
+void GpuTimer::Begin() {
+  if (issued_ - read_ == kQueryCount) {
+    return;
+  }
+  glBeginQuery(GL_TIME_ELAPSED, queries_[issued_ % kQueryCount]);
+  active_ = true;
+}
+
+void GpuTimer::End() {
+  if (!active_) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  issued_++;
+  active_ = false;
+}
+
+bool GpuTimer::Poll(GLuint64* ns) {
+  if (read_ == issued_) {
+    return false;
+  }
+  const GLuint query = queries_[read_ % kQueryCount];
+  GLint available = GL_FALSE;
+  glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return false;
+  }
+  glGetQueryObjectui64v(query, GL_QUERY_RESULT, ns);
+  read_++;
+  return true;
+}
+
+void VertexAttribPointer(GLuint index, const VertexAttribFormat& format,
+                         GLsizei stride, size_t offset) {
+  glVertexAttribPointer(index, format.size, format.type,
+                        format.normalized ? GL_TRUE : GL_FALSE, stride,
+                        reinterpret_cast<const void*>(offset));
+}
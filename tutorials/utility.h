@@ -4,6 +4,10 @@
 // TODO: Try to avoid include glew.h in a header.
 #include <GL/glew.h>
 
+#include <cstddef>
+
+#include "ogldev_quantize.h"
+
 // Check GL error, print it if any.
 void CheckError();
 
@@ -12,4 +16,43 @@ GLuint LoadShader(const char* shader_filename, GLenum shader_type);
 GLuint CreateProgram(const char* vert_shader_path,
                      const char* frag_shader_path);
 
+// glVertexAttribPointer for an attribute stored as |format| (e.g. one of the
+// quantized formats from ogldev_quantize.h), |offset| bytes into each
+// |stride|-byte vertex of the bound GL_ARRAY_BUFFER.
+void VertexAttribPointer(GLuint index, const VertexAttribFormat& format,
+                         GLsizei stride, size_t offset);
+
+// GPU time of the commands between Begin() and End(), from GL_TIME_ELAPSED
+// queries. Results arrive a few frames late and are read without stalling:
+//
+//   timer.Begin();
+//   ...  // Draw.
+//   timer.End();
+//   GLuint64 ns;
+//   while (timer.Poll(&ns)) stats.AddGpuTime(ns);
+//
+// Needs a current GL 3.3 context.
+class GpuTimer {
+ public:
+  GpuTimer();
+  ~GpuTimer();
+
+  // A Begin()/End() pair is skipped while all queries are in flight.
+  void Begin();
+  void End();
+  // Returns the oldest result that is ready, if any.
+  bool Poll(GLuint64* ns);
+
+ private:
+  static const GLuint kQueryCount = 4;
+
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  GLuint queries_[kQueryCount];
+  GLuint issued_;  // Queries ended so far.
+  GLuint read_;    // Results read so far.
+  bool active_;
+};
+
 #endif  // UTILITY_H_